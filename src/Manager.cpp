@@ -1,10 +1,12 @@
 #include "Manager.h"
+#include "Trace.h"
 #include <algorithm>
 
 // for visualisation:
 #include <fstream>
 #include <iostream>
 #include <set>
+#include <stdexcept>
 
 namespace ClassProject {
     Manager::Manager() {
@@ -36,10 +38,49 @@ namespace ClassProject {
         return nodes.size();
     }
 
+    size_t Manager::computedTableSize() const {
+        return computedTable.size();
+    }
+
+    size_t Manager::nodeCount(BDD_ID f) {
+        // New epoch instead of clearing the marks, they are only reset when the counter wraps
+        if (visitMarks.size() < nodes.size()) visitMarks.resize(nodes.size(), visitEpoch);
+        if (++visitEpoch == 0) {
+            std::fill(visitMarks.begin(), visitMarks.end(), 0);
+            visitEpoch = 1;
+        }
+
+        size_t count = 0;
+        visitStack.assign(1, f);
+        while (!visitStack.empty()) {
+            BDD_ID g = visitStack.back();
+            visitStack.pop_back();
+            if (visitMarks.at(g) == visitEpoch) continue;
+            visitMarks[g] = visitEpoch;
+            count++;
+            if (!isConstant(g)) {
+                visitStack.push_back(nodes[g].high);
+                visitStack.push_back(nodes[g].low);
+            }
+        }
+        return count;
+    }
+
+    const ManagerStats &Manager::stats() const {
+        return counters;
+    }
+
+    void Manager::resetStats() {
+        counters = ManagerStats();
+    }
+
     BDD_ID Manager::createVar(const std::string &label) {
         BDD_ID new_id = nodes.size();
         nodes.push_back({new_id, TRUE_ID, FALSE_ID, new_id, label});
 
+        // Register the variable node, otherwise ite would create a second node for the same function
+        uniqueTable[{TRUE_ID, FALSE_ID, new_id}] = new_id;
+
         return new_id;
     }
 
@@ -50,6 +91,8 @@ namespace ClassProject {
     }
 
     BDD_ID Manager::ite(BDD_ID i, BDD_ID t, BDD_ID e) {
+        counters.iteCalls++;
+
         // For Terminal Cases
         if (i == TRUE_ID) return t;
         if (i == FALSE_ID) return e;
@@ -59,8 +102,10 @@ namespace ClassProject {
         // For Computed Table entry. (From Bryant's ite algo. Prevents recalculating when recursing)
         ComputedKey key = {i, t, e};
         if (computedTable.count(key)) {
+            counters.computedHits++;
             return computedTable[key];
         }
+        counters.computedMisses++;
 
         // For Recursive Cases
         BDD_ID top = topVar(i);
@@ -85,7 +130,9 @@ namespace ClassProject {
         UniqueKey uniqueKey = {r_high, r_low, top};
 
         // Check if it already exists
+        counters.uniqueLookups++;
         if (uniqueTable.count(uniqueKey)) {
+            counters.uniqueHits++;
             BDD_ID node = uniqueTable[uniqueKey];
 
             // New node not created, save working in the computedTable for use in future recursion
@@ -206,6 +253,380 @@ namespace ClassProject {
     }
 
 
+    BDD_ID Manager::andExists(BDD_ID f, BDD_ID g, const std::vector<BDD_ID> &vars) {
+        // Mark quantified variables by ID for O(1) lookup during the recursion
+        std::vector<bool> quantified(nodes.size(), false);
+        for (BDD_ID var: vars) {
+            quantified[var] = true;
+        }
+
+        std::unordered_map<ComputedKey, BDD_ID, KeyHasher> memo;
+        return andExistsRec(f, g, quantified, memo);
+    }
+
+    BDD_ID Manager::andExistsRec(BDD_ID f, BDD_ID g, const std::vector<bool> &quantified,
+                                 std::unordered_map<ComputedKey, BDD_ID, KeyHasher> &memo) {
+        // Terminal Cases
+        if (f == FALSE_ID || g == FALSE_ID) return FALSE_ID;
+        if (f == TRUE_ID && g == TRUE_ID) return TRUE_ID;
+
+        // AND is commutative, normalize the key to get more memo hits
+        if (f > g) std::swap(f, g);
+
+        ComputedKey key = {f, g, 0};
+        auto cached = memo.find(key);
+        if (cached != memo.end()) {
+            return cached->second;
+        }
+
+        BDD_ID top = isConstant(f) ? topVar(g) : topVar(f);
+        if (!isConstant(g) && topVar(g) < top) {
+            top = topVar(g);
+        }
+
+        BDD_ID r_high = andExistsRec(coFactorTrue(f, top), coFactorTrue(g, top), quantified, memo);
+
+        BDD_ID result;
+        if (quantified[top]) {
+            // exists top. h = h_high OR h_low, the low branch is not needed if the high branch is already True
+            result = (r_high == TRUE_ID)
+                         ? TRUE_ID
+                         : or2(r_high, andExistsRec(coFactorFalse(f, top), coFactorFalse(g, top), quantified, memo));
+        } else {
+            BDD_ID r_low = andExistsRec(coFactorFalse(f, top), coFactorFalse(g, top), quantified, memo);
+            result = ite(top, r_high, r_low);
+        }
+
+        memo[key] = result;
+        return result;
+    }
+
+    BDD_ID Manager::existQuantify(BDD_ID f, const std::vector<BDD_ID> &vars) {
+        return andExists(f, TRUE_ID, vars);
+    }
+
+    BDD_ID Manager::rename(BDD_ID f, const std::vector<BDD_ID> &from, const std::vector<BDD_ID> &to) {
+        if (from.size() != to.size()) {
+            throw std::runtime_error("Size mismatch");
+        }
+
+        // Map every variable onto itself, except the renamed ones
+        std::vector<BDD_ID> varMap(nodes.size());
+        for (BDD_ID id = 0; id < varMap.size(); id++) {
+            varMap[id] = id;
+        }
+        for (size_t i = 0; i < from.size(); i++) {
+            varMap[from[i]] = to[i];
+        }
+
+        std::unordered_map<BDD_ID, BDD_ID> memo;
+        return renameRec(f, varMap, memo);
+    }
+
+    BDD_ID Manager::renameRec(BDD_ID f, const std::vector<BDD_ID> &varMap,
+                              std::unordered_map<BDD_ID, BDD_ID> &memo) {
+        if (isConstant(f)) return f;
+
+        auto cached = memo.find(f);
+        if (cached != memo.end()) {
+            return cached->second;
+        }
+
+        // ite restores the variable order, so the mapping does not need to be order preserving
+        BDD_ID r_high = renameRec(nodes[f].high, varMap, memo);
+        BDD_ID r_low = renameRec(nodes[f].low, varMap, memo);
+        BDD_ID result = ite(varMap[topVar(f)], r_high, r_low);
+
+        memo[f] = result;
+        return result;
+    }
+
+    BDD_ID Manager::restrict(BDD_ID f, BDD_ID c) {
+        std::unordered_map<ComputedKey, BDD_ID, KeyHasher> memo;
+        return restrictRec(f, c, memo);
+    }
+
+    BDD_ID Manager::restrictRec(BDD_ID f, BDD_ID c, std::unordered_map<ComputedKey, BDD_ID, KeyHasher> &memo) {
+        // Terminal Cases: empty care set allows anything, keep f as is
+        if (c == FALSE_ID || c == TRUE_ID || isConstant(f)) return f;
+        if (f == c) return TRUE_ID;
+
+        ComputedKey key = {f, c, 0};
+        auto cached = memo.find(key);
+        if (cached != memo.end()) {
+            return cached->second;
+        }
+
+        BDD_ID result;
+        BDD_ID top = topVar(f);
+        if (topVar(c) < top) {
+            // f does not depend on the top variable of c, quantify it out of the care set
+            result = restrictRec(f, or2(coFactorTrue(c), coFactorFalse(c)), memo);
+        } else {
+            BDD_ID c_high = coFactorTrue(c, top);
+            BDD_ID c_low = coFactorFalse(c, top);
+            if (c_high == FALSE_ID) {
+                result = restrictRec(coFactorFalse(f), c_low, memo);
+            } else if (c_low == FALSE_ID) {
+                result = restrictRec(coFactorTrue(f), c_high, memo);
+            } else {
+                result = ite(top, restrictRec(coFactorTrue(f), c_high, memo),
+                             restrictRec(coFactorFalse(f), c_low, memo));
+            }
+        }
+
+        memo[key] = result;
+        return result;
+    }
+
+    BDD_ID Manager::constrain(BDD_ID f, BDD_ID c) {
+        std::unordered_map<ComputedKey, BDD_ID, KeyHasher> memo;
+        return constrainRec(f, c, memo);
+    }
+
+    BDD_ID Manager::constrainRec(BDD_ID f, BDD_ID c, std::unordered_map<ComputedKey, BDD_ID, KeyHasher> &memo) {
+        // Terminal Cases
+        if (c == FALSE_ID) return FALSE_ID;
+        if (c == TRUE_ID || isConstant(f)) return f;
+        if (f == c) return TRUE_ID;
+
+        ComputedKey key = {f, c, 0};
+        auto cached = memo.find(key);
+        if (cached != memo.end()) {
+            return cached->second;
+        }
+
+        BDD_ID top = topVar(c);
+        if (topVar(f) < top) {
+            top = topVar(f);
+        }
+
+        BDD_ID c_high = coFactorTrue(c, top);
+        BDD_ID c_low = coFactorFalse(c, top);
+
+        BDD_ID result;
+        if (c_high == FALSE_ID) {
+            result = constrainRec(coFactorFalse(f, top), c_low, memo);
+        } else if (c_low == FALSE_ID) {
+            result = constrainRec(coFactorTrue(f, top), c_high, memo);
+        } else {
+            result = ite(top, constrainRec(coFactorTrue(f, top), c_high, memo),
+                         constrainRec(coFactorFalse(f, top), c_low, memo));
+        }
+
+        memo[key] = result;
+        return result;
+    }
+
+    bool Manager::implies(BDD_ID f, BDD_ID g) {
+        std::unordered_map<ComputedKey, bool, KeyHasher> memo;
+        return impliesRec(f, g, memo);
+    }
+
+    bool Manager::impliesRec(BDD_ID f, BDD_ID g, std::unordered_map<ComputedKey, bool, KeyHasher> &memo) {
+        // Terminal Cases
+        if (f == FALSE_ID || g == TRUE_ID || f == g) return true;
+        if (f == TRUE_ID || g == FALSE_ID) return false;
+
+        ComputedKey key = {f, g, 0};
+        auto cached = memo.find(key);
+        if (cached != memo.end()) {
+            return cached->second;
+        }
+
+        BDD_ID top = std::min(topVar(f), topVar(g));
+
+        // Cofactors wrt the top variable are plain children, so unlike coFactorTrue no ite call is needed
+        BDD_ID f_high = (topVar(f) == top) ? nodes[f].high : f;
+        BDD_ID f_low = (topVar(f) == top) ? nodes[f].low : f;
+        BDD_ID g_high = (topVar(g) == top) ? nodes[g].high : g;
+        BDD_ID g_low = (topVar(g) == top) ? nodes[g].low : g;
+
+        bool result = impliesRec(f_high, g_high, memo) && impliesRec(f_low, g_low, memo);
+        memo[key] = result;
+        return result;
+    }
+
+    BDD_ID Manager::importFrom(const Manager &src, BDD_ID root, const std::vector<BDD_ID> &varMap) {
+        return importFrom(src, std::vector<BDD_ID>{root}, varMap).front();
+    }
+
+    std::vector<BDD_ID> Manager::importFrom(const Manager &src, const std::vector<BDD_ID> &roots,
+                                            const std::vector<BDD_ID> &varMap) {
+        // Collect every node below the roots once, only reads src so several managers may import concurrently
+        std::unordered_map<BDD_ID, BDD_ID> copies = {{FALSE_ID, FALSE_ID}, {TRUE_ID, TRUE_ID}};
+        std::vector<BDD_ID> order;
+        std::vector<BDD_ID> stack(roots.begin(), roots.end());
+        while (!stack.empty()) {
+            BDD_ID f = stack.back();
+            stack.pop_back();
+            if (!copies.emplace(f, FALSE_ID).second) continue;
+            order.push_back(f);
+            stack.push_back(src.nodes.at(f).high);
+            stack.push_back(src.nodes.at(f).low);
+        }
+
+        // Children have smaller IDs than their parents, so ascending order copies them first
+        std::sort(order.begin(), order.end());
+        for (BDD_ID f : order) {
+            const BDDNode &node = src.nodes[f];
+            BDD_ID var = varMap.at(node.topVar);
+            if (var >= nodes.size() || isConstant(var) || topVar(var) != var) {
+                throw std::runtime_error("Variable " + src.nodes[node.topVar].label + " is not mapped to a variable");
+            }
+            BDD_ID r_high = copies[node.high];
+            BDD_ID r_low = copies[node.low];
+
+            // With the same order below var the node is built directly, otherwise ite restores the local order
+            bool ordered = (isConstant(r_high) || var < topVar(r_high)) && (isConstant(r_low) || var < topVar(r_low));
+            copies[f] = ordered ? findOrAddNode(var, r_high, r_low) : ite(var, r_high, r_low);
+        }
+
+        std::vector<BDD_ID> result;
+        result.reserve(roots.size());
+        for (BDD_ID root : roots) {
+            result.push_back(copies[root]);
+        }
+        return result;
+    }
+
+    std::vector<BDD_ID> Manager::mapVariablesByLabel(const Manager &src) {
+        std::unordered_map<std::string, BDD_ID> localVars;
+        for (BDD_ID id = TRUE_ID + 1; id < nodes.size(); id++) {
+            if (nodes[id].topVar == id) localVars.emplace(nodes[id].label, id);
+        }
+
+        std::vector<BDD_ID> varMap(src.nodes.size(), FALSE_ID);
+        for (BDD_ID id = TRUE_ID + 1; id < src.nodes.size(); id++) {
+            if (src.nodes[id].topVar != id) continue;
+            auto local = localVars.find(src.nodes[id].label);
+            varMap[id] = (local != localVars.end()) ? local->second : createVar(src.nodes[id].label);
+        }
+        return varMap;
+    }
+
+    size_t Manager::garbageCollect(std::vector<BDD_ID> &roots) {
+        TraceSpan span("garbageCollect", "gc", static_cast<int64_t>(nodes.size()));
+
+        // Mark: children always have smaller IDs than their parents, so one descending sweep finds every live node
+        std::vector<bool> live(nodes.size(), false);
+        live[FALSE_ID] = live[TRUE_ID] = true;
+        for (BDD_ID root : roots) {
+            live.at(root) = true;
+        }
+        for (BDD_ID id = nodes.size() - 1; id > TRUE_ID; id--) {
+            // Variables define the order and are always kept
+            if (nodes[id].topVar == id) live[id] = true;
+            if (!live[id]) continue;
+            live[nodes[id].high] = true;
+            live[nodes[id].low] = true;
+        }
+
+        // Compact: survivors keep their relative order, which keeps the variable order and child IDs < parent IDs
+        std::vector<BDD_ID> newId(nodes.size());
+        BDD_ID next = 0;
+        for (BDD_ID id = 0; id < nodes.size(); id++) {
+            if (!live[id]) continue;
+            newId[id] = next;
+            BDDNode node = std::move(nodes[id]);
+            node.id = next;
+            node.high = newId[node.high];
+            node.low = newId[node.low];
+            node.topVar = newId[node.topVar];
+            nodes[next++] = std::move(node);
+        }
+        size_t freed = nodes.size() - next;
+        nodes.resize(next);
+
+        // Renumbering does not change the structure, so cached hashes move along. Survivors without a cached
+        // hash may land on the slot of a dead node with one, so the hashes are rebuilt instead of moved in place
+        std::vector<uint64_t> hashes(structuralHashes.empty() ? 0 : next, 0);
+        for (BDD_ID id = 0; id < structuralHashes.size(); id++) {
+            if (live[id]) hashes[newId[id]] = structuralHashes[id];
+        }
+        structuralHashes = std::move(hashes);
+
+        // Cached results refer to old IDs, the unique table is rebuilt from the survivors
+        computedTable.clear();
+        uniqueTable.clear();
+        for (BDD_ID id = TRUE_ID + 1; id < nodes.size(); id++) {
+            uniqueTable[{nodes[id].high, nodes[id].low, nodes[id].topVar}] = id;
+        }
+
+        for (BDD_ID &root : roots) {
+            root = newId[root];
+        }
+        return freed;
+    }
+
+    // splitmix64 finalizer, spreads every input bit over the whole word
+    static uint64_t mixHash(uint64_t z) {
+        z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+        z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+        return z ^ (z >> 31);
+    }
+
+    uint64_t Manager::structuralHash(BDD_ID f) {
+        // 0 marks a missing hash and 1 a node waiting for its children, real hashes avoid both
+        const uint64_t NO_HASH = 0, PENDING = 1;
+        if (structuralHashes.size() < nodes.size()) {
+            structuralHashes.resize(nodes.size(), NO_HASH);
+        }
+        if (structuralHashes.at(f) > PENDING) {
+            return structuralHashes[f];
+        }
+
+        // Collect the nodes below f without a hash, children have smaller IDs so ascending order hashes them first
+        std::vector<BDD_ID> pending;
+        std::vector<BDD_ID> stack{f};
+        while (!stack.empty()) {
+            BDD_ID g = stack.back();
+            stack.pop_back();
+            if (structuralHashes[g] != NO_HASH) continue;
+            structuralHashes[g] = PENDING;
+            pending.push_back(g);
+            if (!isConstant(g)) {
+                stack.push_back(nodes[g].high);
+                stack.push_back(nodes[g].low);
+            }
+        }
+        std::sort(pending.begin(), pending.end());
+
+        for (BDD_ID g : pending) {
+            uint64_t hash;
+            if (isConstant(g)) {
+                hash = mixHash(g + 0x9e3779b97f4a7c15ULL);
+            } else {
+                // FNV-1a of the variable name, then the high and the low child in this order
+                hash = 0xcbf29ce484222325ULL;
+                for (const char c : nodes[nodes[g].topVar].label) {
+                    hash = (hash ^ static_cast<unsigned char>(c)) * 0x100000001b3ULL;
+                }
+                hash = mixHash(mixHash(hash) ^ structuralHashes[nodes[g].high]);
+                hash = mixHash(hash ^ (structuralHashes[nodes[g].low] + 0x9e3779b97f4a7c15ULL));
+            }
+            structuralHashes[g] = (hash > PENDING) ? hash : hash + 2;
+        }
+        return structuralHashes[f];
+    }
+
+    BDD_ID Manager::findOrAddNode(BDD_ID top, BDD_ID high, BDD_ID low) {
+        if (high == low) return high;
+
+        UniqueKey uniqueKey = {high, low, top};
+        counters.uniqueLookups++;
+        auto existing = uniqueTable.find(uniqueKey);
+        if (existing != uniqueTable.end()) {
+            counters.uniqueHits++;
+            return existing->second;
+        }
+
+        BDD_ID new_id = nodes.size();
+        nodes.push_back({new_id, high, low, top, ""});
+        uniqueTable[uniqueKey] = new_id;
+        return new_id;
+    }
+
     void Manager::visualizeBDD(std::string filepath, BDD_ID &root) {
         std::ofstream outputFile(filepath);
         if (!outputFile.is_open()) {
@@ -6,6 +6,7 @@
 #include <string>
 #include <set>
 #include <unordered_map>
+#include <cstdint>
 
 namespace ClassProject {
     struct BDDNode {
@@ -44,6 +45,15 @@ namespace ClassProject {
         }
     };
 
+    // Operation counters of a Manager, for profiling the kernel. Reset with Manager::resetStats
+    struct ManagerStats {
+        size_t iteCalls = 0;        // ite calls, including the recursive ones
+        size_t computedHits = 0;    // ite calls answered from the computed table
+        size_t computedMisses = 0;  // ite calls that recursed, the rest were terminal cases
+        size_t uniqueLookups = 0;   // nodes looked up in the unique table by ite and findOrAddNode
+        size_t uniqueHits = 0;      // lookups that found an existing node
+    };
+
     class Manager : public ManagerInterface {
     private:
         std::vector<BDDNode> nodes;
@@ -52,6 +62,21 @@ namespace ClassProject {
 
         void visualizeNode(BDD_ID id, std::ostream &outputFile, std::set<BDD_ID> &visitedNodes);
 
+        // Recursive relational product, memo is local to one andExists call since the quantified set varies
+        BDD_ID andExistsRec(BDD_ID f, BDD_ID g, const std::vector<bool> &quantified,
+                            std::unordered_map<ComputedKey, BDD_ID, KeyHasher> &memo);
+
+        BDD_ID renameRec(BDD_ID f, const std::vector<BDD_ID> &varMap, std::unordered_map<BDD_ID, BDD_ID> &memo);
+
+        BDD_ID restrictRec(BDD_ID f, BDD_ID c, std::unordered_map<ComputedKey, BDD_ID, KeyHasher> &memo);
+
+        BDD_ID constrainRec(BDD_ID f, BDD_ID c, std::unordered_map<ComputedKey, BDD_ID, KeyHasher> &memo);
+
+        bool impliesRec(BDD_ID f, BDD_ID g, std::unordered_map<ComputedKey, bool, KeyHasher> &memo);
+
+        // Returns the node (top, high, low), creating it if needed. top must be above both children
+        BDD_ID findOrAddNode(BDD_ID top, BDD_ID high, BDD_ID low);
+
         // we specify the map as: Container <Key, Value, Hasher> name;
 
         // The Cache: Prevents recalculating the recursion in ite
@@ -60,6 +85,16 @@ namespace ClassProject {
         // The Nodefinder: Such that nodes are reused if already existing/For Canonicity
         std::unordered_map<UniqueKey, BDD_ID, KeyHasher> uniqueTable;
 
+        ManagerStats counters;
+
+        // Cached structuralHash of each node, 0 if not computed yet. Nodes never change, so entries stay valid
+        std::vector<uint64_t> structuralHashes;
+
+        // Scratch space of nodeCount, a node is visited in the current count if its mark equals visitEpoch
+        std::vector<uint32_t> visitMarks;
+        uint32_t visitEpoch = 0;
+        std::vector<BDD_ID> visitStack;
+
     public:
         Manager();
 
@@ -107,7 +142,59 @@ namespace ClassProject {
 
         size_t uniqueTableSize() override;
 
+        // Number of ite results cached in the computed table
+        size_t computedTableSize() const;
+
+        // Number of nodes of the BDD rooted at f, terminals included. Same as findNodes, but without building a set
+        size_t nodeCount(BDD_ID f);
+
+        // Operation counters since construction or the last resetStats
+        const ManagerStats &stats() const;
+
+        void resetStats();
+
         void visualizeBDD(std::string filepath, BDD_ID &root) override;
+
+        // Relational product: exists vars. (f AND g), without building the full conjunction first
+        BDD_ID andExists(BDD_ID f, BDD_ID g, const std::vector<BDD_ID> &vars);
+
+        // Existential quantification: exists vars. f
+        BDD_ID existQuantify(BDD_ID f, const std::vector<BDD_ID> &vars);
+
+        // Variable renaming: replaces every occurrence of from[i] in f by to[i]
+        BDD_ID rename(BDD_ID f, const std::vector<BDD_ID> &from, const std::vector<BDD_ID> &to);
+
+        // Coudert-Madre restrict: agrees with f wherever the care set c holds, never larger than f in practice
+        BDD_ID restrict(BDD_ID f, BDD_ID c);
+
+        // Generalized cofactor f|c: agrees with f wherever c holds
+        BDD_ID constrain(BDD_ID f, BDD_ID c);
+
+        // true if f -> g is a tautology. Only walks the existing graphs, no node is created
+        bool implies(BDD_ID f, BDD_ID g);
+
+        // Copies the BDD rooted at 'root' from another manager. varMap[v] is the local variable for variable v of src
+        BDD_ID importFrom(const Manager &src, BDD_ID root, const std::vector<BDD_ID> &varMap);
+
+        // Copies several BDDs from another manager at once, subgraphs shared by the roots are copied only once.
+        // Iterative, so the depth of the BDDs is not limited by the stack. Throws if a variable of the roots
+        // is not mapped to a local variable
+        std::vector<BDD_ID> importFrom(const Manager &src, const std::vector<BDD_ID> &roots,
+                                       const std::vector<BDD_ID> &varMap);
+
+        // Variable map for importFrom: every variable of src maps to the local variable of the same label.
+        // Missing variables are created in the order of src
+        std::vector<BDD_ID> mapVariablesByLabel(const Manager &src);
+
+        // Compacting garbage collection. Keeps the terminals, all variables and every node reachable from roots,
+        // then renumbers the survivors and updates roots in place. Every other BDD_ID held outside becomes invalid.
+        // Returns the number of nodes freed
+        size_t garbageCollect(std::vector<BDD_ID> &roots);
+
+        // Canonical fingerprint of the graph below f, Merkle-style over the variable names and the hashes of the
+        // children. Independent of the IDs, so equal across managers and runs for the same function, variable names
+        // and variable order. Cached per node, so repeated calls only hash the nodes created since
+        uint64_t structuralHash(BDD_ID f);
     };
 }
 #endif
@@ -0,0 +1,148 @@
+#include "Trace.h"
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace ClassProject {
+    std::atomic<bool> Trace::active{false};
+
+    namespace {
+        struct TraceEvent {
+            const char *name;
+            const char *category;
+            uint64_t start;
+            uint64_t end;
+            int64_t arg;
+        };
+
+        // Spans of one thread at a time. Only the owning thread writes. A finished thread hands its buffer
+        // to the next new one, which continues the ring, so there are only as many buffers as threads ever
+        // recorded at the same time and short-lived workers do not pile up buffers
+        struct ThreadBuffer {
+            std::vector<TraceEvent> events; // grows up to the capacity, then wraps
+            size_t recorded = 0; // spans ever recorded, the newest is at (recorded - 1) % events.size()
+            size_t thread = 0;   // number in order of creation, the tid in the JSON
+        };
+
+        std::mutex registryMutex;
+        std::vector<std::unique_ptr<ThreadBuffer>> registry;
+        std::vector<ThreadBuffer *> freeBuffers;
+        std::atomic<size_t> bufferCapacity{1 << 16};
+        uint64_t origin = 0;
+
+        // Returns the buffer of its thread to the free list when the thread ends
+        struct BufferOwner {
+            ThreadBuffer *buffer = nullptr;
+
+            ~BufferOwner() {
+                if (buffer == nullptr) return;
+                std::lock_guard<std::mutex> lock(registryMutex);
+                freeBuffers.push_back(buffer);
+            }
+        };
+
+        thread_local BufferOwner localBuffer;
+
+        ThreadBuffer &threadBuffer() {
+            if (localBuffer.buffer == nullptr) {
+                std::lock_guard<std::mutex> lock(registryMutex);
+                if (freeBuffers.empty()) {
+                    registry.push_back(std::make_unique<ThreadBuffer>());
+                    registry.back()->thread = registry.size();
+                    localBuffer.buffer = registry.back().get();
+                } else {
+                    localBuffer.buffer = freeBuffers.back();
+                    freeBuffers.pop_back();
+                }
+            }
+            return *localBuffer.buffer;
+        }
+
+        // Microseconds since enable, with the nanoseconds as fraction
+        void writeMicroseconds(std::ostream &out, uint64_t ns) {
+            out << ns / 1000 << "." << (ns % 1000) / 100 << (ns % 100) / 10 << ns % 10;
+        }
+    }
+
+    void Trace::enable(size_t capacity) {
+        std::lock_guard<std::mutex> lock(registryMutex);
+        bufferCapacity.store((capacity == 0) ? 1 : capacity, std::memory_order_relaxed);
+        if (origin == 0) origin = now();
+        active.store(true, std::memory_order_relaxed);
+    }
+
+    void Trace::disable() {
+        std::lock_guard<std::mutex> lock(registryMutex);
+        active.store(false, std::memory_order_relaxed);
+        for (const auto &buffer: registry) {
+            std::vector<TraceEvent>().swap(buffer->events);
+            buffer->recorded = 0;
+        }
+    }
+
+    size_t Trace::threadBuffers() {
+        std::lock_guard<std::mutex> lock(registryMutex);
+        return registry.size();
+    }
+
+    uint64_t Trace::now() {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    void Trace::record(const char *name, const char *category, uint64_t start, uint64_t end, int64_t arg) {
+        ThreadBuffer &buffer = threadBuffer();
+        if (buffer.recorded == buffer.events.size() &&
+            buffer.events.size() < bufferCapacity.load(std::memory_order_relaxed)) {
+            buffer.events.push_back({name, category, start, end, arg});
+        } else {
+            buffer.events[buffer.recorded % buffer.events.size()] = {name, category, start, end, arg};
+        }
+        buffer.recorded++;
+    }
+
+    bool Trace::write(const std::string &file) {
+        std::ofstream out(file);
+        if (!out.is_open()) {
+            return false;
+        }
+
+        std::lock_guard<std::mutex> lock(registryMutex);
+        out << "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [" << std::endl;
+        bool first = true;
+        for (const auto &buffer: registry) {
+            out << (first ? "" : ",\n") << "{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 1, \"tid\": "
+                << buffer->thread << ", \"args\": {\"name\": \"thread " << buffer->thread << "\"}}";
+            first = false;
+
+            if (buffer->recorded == 0) continue;
+
+            // Oldest span first, a full ring starts after the newest one
+            size_t capacity = buffer->events.size();
+            size_t count = std::min(buffer->recorded, capacity);
+            for (size_t i = buffer->recorded - count; i < buffer->recorded; i++) {
+                const TraceEvent &event = buffer->events[i % capacity];
+                uint64_t start = (event.start > origin) ? event.start - origin : 0;
+                out << ",\n{\"name\": \"" << event.name << "\", \"cat\": \"" << event.category
+                    << "\", \"ph\": \"X\", \"pid\": 1, \"tid\": " << buffer->thread << ", \"ts\": ";
+                writeMicroseconds(out, start);
+                out << ", \"dur\": ";
+                writeMicroseconds(out, event.end - event.start);
+                if (event.arg >= 0) {
+                    out << ", \"args\": {\"n\": " << event.arg << "}";
+                }
+                out << "}";
+            }
+            if (buffer->recorded > capacity) {
+                out << ",\n{\"name\": \"dropped spans\", \"ph\": \"i\", \"s\": \"t\", \"pid\": 1, \"tid\": "
+                    << buffer->thread << ", \"ts\": 0, \"args\": {\"n\": " << buffer->recorded - capacity << "}}";
+            }
+        }
+        out << "\n]}" << std::endl;
+        return out.good();
+    }
+}
@@ -0,0 +1,64 @@
+#ifndef VDSPROJECT_TRACE_H
+#define VDSPROJECT_TRACE_H
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+namespace ClassProject {
+    // Timeline of scoped spans, written in the Chrome trace event format that chrome://tracing and Perfetto
+    // open. Disabled by default, a span then costs one relaxed load. Once enabled, every thread records into
+    // a ring buffer of its own without locking and keeps its newest spans. Buffers of finished threads are
+    // reused by later threads
+    class Trace {
+    public:
+        // Starts recording, every thread keeps up to 'capacity' spans
+        static void enable(size_t capacity = 1 << 16);
+
+        // Stops recording and drops all recorded spans. Call it when no traced work runs anymore
+        static void disable();
+
+        static bool enabled() {
+            return active.load(std::memory_order_relaxed);
+        }
+
+        // Number of ring buffers, at most the number of threads that recorded spans at the same time
+        static size_t threadBuffers();
+
+        // Nanoseconds of a monotonic clock
+        static uint64_t now();
+
+        // Records a finished span of the calling thread. name and category are not copied, so they must
+        // outlive the trace, string literals do. arg is shown with the span unless it is negative
+        static void record(const char *name, const char *category, uint64_t start, uint64_t end, int64_t arg);
+
+        // Writes the spans of all threads as JSON. Call it when no traced work runs anymore.
+        // Returns false if the file cannot be written
+        static bool write(const std::string &file);
+
+    private:
+        static std::atomic<bool> active;
+    };
+
+    // Records the time from its construction to its destruction as one span, if tracing is enabled
+    class TraceSpan {
+    public:
+        TraceSpan(const char *name, const char *category, int64_t arg = -1)
+                : name(name), category(category), arg(arg), start(Trace::enabled() ? Trace::now() : 0) {}
+
+        ~TraceSpan() {
+            if (start != 0) Trace::record(name, category, start, Trace::now(), arg);
+        }
+
+        TraceSpan(const TraceSpan &) = delete;
+
+        TraceSpan &operator=(const TraceSpan &) = delete;
+
+    private:
+        const char *name;
+        const char *category;
+        int64_t arg;
+        uint64_t start;
+    };
+}
+#endif
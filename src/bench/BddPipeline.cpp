@@ -0,0 +1,88 @@
+//
+// Writing finished output BDDs on a thread of its own while the build continues
+//
+
+#include "BddPipeline.hpp"
+#include "../Trace.h"
+
+#include <algorithm>
+#include <utility>
+
+
+BddPipeline::BddPipeline(const std::string &result_dir, unsigned int formats, size_t max_queued_nodes)
+        : result_dir(result_dir), formats(formats), max_queued_nodes(max_queued_nodes) {
+    writer = std::thread(&BddPipeline::Run, this);
+}
+
+BddPipeline::~BddPipeline() {
+    try {
+        Finish();
+    } catch (...) {
+        /* Errors are only reported by an explicit Finish */
+    }
+}
+
+void BddPipeline::Run() {
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true) {
+        changed.wait(lock, [this]() { return !queue.empty() || closed; });
+        if (queue.empty()) break;
+
+        /* The snapshot stays queued while it is written, so its nodes count until it is done */
+        const BddWriter &bdds = queue.front();
+        bool failed = (error != nullptr);
+        lock.unlock();
+        std::exception_ptr write_error;
+        if (!failed) {
+            try {
+                bdds.WriteRoots(result_dir, 1, formats);
+            } catch (...) {
+                write_error = std::current_exception();
+            }
+        }
+        lock.lock();
+
+        if (write_error && !error) error = write_error;
+        if (!failed && !write_error) written_roots += bdds.GetSnapshot().roots.size();
+        queued_nodes -= bdds.GetSnapshot().nodes.size();
+        queue.pop_front();
+        changed.notify_all();
+    }
+}
+
+void BddPipeline::Push(BddWriter bdds) {
+    size_t nodes = bdds.GetSnapshot().nodes.size();
+    /* Time the build waits for the writer to catch up */
+    ClassProject::TraceSpan span("pipelinePush", "print", static_cast<int64_t>(nodes));
+    std::unique_lock<std::mutex> lock(mutex);
+    changed.wait(lock, [&]() { return queue.empty() || queued_nodes + nodes <= max_queued_nodes; });
+
+    queued_nodes += nodes;
+    queue.push_back(std::move(bdds));
+    max_queue_length = std::max(max_queue_length, queue.size());
+    changed.notify_all();
+}
+
+void BddPipeline::Finish() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        closed = true;
+    }
+    changed.notify_all();
+    if (writer.joinable()) {
+        writer.join();
+    }
+    if (error) {
+        std::rethrow_exception(std::exchange(error, nullptr));
+    }
+}
+
+size_t BddPipeline::GetWrittenRoots() {
+    std::lock_guard<std::mutex> lock(mutex);
+    return written_roots;
+}
+
+size_t BddPipeline::GetMaxQueueLength() {
+    std::lock_guard<std::mutex> lock(mutex);
+    return max_queue_length;
+}
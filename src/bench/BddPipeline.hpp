@@ -0,0 +1,94 @@
+//
+// Writing finished output BDDs on a thread of its own while the build continues
+//
+
+#pragma once
+
+#include "BddWriter.hpp"
+
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <mutex>
+#include <thread>
+
+/**
+ * \class BddPipeline
+ *
+ * \brief Queue of BDD snapshots written by a writer thread.
+ *
+ *  The building thread pushes a BddWriter as soon as an output is final, the writer thread
+ *   takes them in order and writes their files. The snapshots do not refer to the manager,
+ *   so the build goes on while earlier outputs are written. Push blocks while the queued
+ *   snapshots hold more than max_queued_nodes nodes, which bounds the memory of the queue.
+ */
+class BddPipeline {
+private:
+    std::string result_dir;    ///< Directory holding the txt, dot and bin directories
+    unsigned int formats;      ///< Mask of bdd_format_t
+    size_t max_queued_nodes;   ///< Nodes the queue may hold before Push blocks
+
+    std::mutex mutex;                 ///< Guards everything below
+    std::condition_variable changed;  ///< Signals pushes, finished writes and the end of the input
+    std::deque<BddWriter> queue;
+    size_t queued_nodes = 0;
+    size_t max_queue_length = 0;
+    size_t written_roots = 0;
+    bool closed = false;              ///< No more pushes will come
+    std::exception_ptr error;         ///< First error of the writer thread, later snapshots are dropped
+
+    std::thread writer;
+
+    /**
+     * \brief Body of the writer thread.
+     * \return none
+     */
+    void Run();
+
+public:
+    /**
+     * \brief Constructor, starts the writer thread.
+     * \param result_dir is the directory to write to, see BddWriter::CreateDirectories
+     * \param formats is a mask of bdd_format_t
+     * \param max_queued_nodes is the number of queued nodes from which on Push waits for the writer
+     */
+    BddPipeline(const std::string &result_dir, unsigned int formats, size_t max_queued_nodes = 1 << 22);
+
+    /**
+     * \brief Destructor, waits for the writer thread and drops its errors.
+     */
+    ~BddPipeline();
+
+    BddPipeline(const BddPipeline &) = delete;
+    BddPipeline &operator=(const BddPipeline &) = delete;
+
+    /**
+     * \brief Queues the roots of a snapshot to be written, each to files of its own.
+     * \param bdds is the snapshot
+     * \return none
+     */
+    void Push(BddWriter bdds);
+
+    /**
+     * \brief Waits until everything pushed is written and stops the writer thread.
+     * \param none
+     * \return none
+     *
+     * \throws the first error of the writer thread, e.g. std::runtime_error if a file cannot be written
+     */
+    void Finish();
+
+    /**
+     * \brief return the number of roots written so far.
+     * \param none
+     * \return size_t
+     */
+    size_t GetWrittenRoots();
+
+    /**
+     * \brief return the most snapshots that were waiting for the writer at once.
+     * \param none
+     * \return size_t
+     */
+    size_t GetMaxQueueLength();
+};
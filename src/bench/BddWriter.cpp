@@ -0,0 +1,357 @@
+//
+// Batched writing of the BDDs of many outputs
+//
+
+#include "BddWriter.hpp"
+#include "../Trace.h"
+
+#include <algorithm>
+#include <atomic>
+#include <charconv>
+#include <exception>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+#include <thread>
+#include <unordered_map>
+
+/* Appends a number without going through a stream */
+static void AppendNumber(std::string &out, size_t number) {
+    char digits[24];
+    auto end = std::to_chars(digits, digits + sizeof(digits), number).ptr;
+    out.append(digits, end);
+}
+
+/* Appends a little-endian 64-bit word */
+static void AppendWord(std::string &out, uint64_t word) {
+    for (int byte = 0; byte < 8; byte++) {
+        out += static_cast<char>((word >> (8 * byte)) & 0xff);
+    }
+}
+
+/* Appends a hash as 16 hex digits */
+static void AppendHash(std::string &out, uint64_t hash) {
+    char digits[16];
+    auto end = std::to_chars(digits, digits + sizeof(digits), hash, 16).ptr;
+    out.append(16 - (end - digits), '0');
+    out.append(digits, end);
+}
+
+static void AppendName(std::string &out, const label_t &name) {
+    AppendWord(out, name.size());
+    out += name;
+}
+
+BddWriter::BddWriter(ClassProject::ManagerInterface &manager, const std::vector<label_t> &root_labels,
+                     const std::vector<ClassProject::BDD_ID> &roots) {
+    if (root_labels.size() != roots.size()) {
+        throw std::runtime_error("Every root to write needs a label!");
+    }
+    ClassProject::TraceSpan span("snapshot", "print", static_cast<int64_t>(roots.size()));
+
+    /* One traversal over all roots, nodes shared by several roots are visited once */
+    std::unordered_map<ClassProject::BDD_ID, size_t> positions;
+    std::vector<ClassProject::BDD_ID> ids;
+    std::vector<ClassProject::BDD_ID> stack(roots.begin(), roots.end());
+    while (!stack.empty()) {
+        ClassProject::BDD_ID f = stack.back();
+        stack.pop_back();
+        if (!positions.emplace(f, 0).second) continue;
+        ids.push_back(f);
+        if (!manager.isConstant(f)) {
+            stack.push_back(manager.coFactorTrue(f));
+            stack.push_back(manager.coFactorFalse(f));
+        }
+    }
+    std::sort(ids.begin(), ids.end());
+
+    for (const auto f : ids) {
+        if (!manager.isConstant(f)) snapshot.variables.push_back(manager.topVar(f));
+    }
+    std::sort(snapshot.variables.begin(), snapshot.variables.end());
+    snapshot.variables.erase(std::unique(snapshot.variables.begin(), snapshot.variables.end()),
+                             snapshot.variables.end());
+    std::unordered_map<ClassProject::BDD_ID, size_t> levels;
+    for (size_t v = 0; v < snapshot.variables.size(); v++) {
+        levels[snapshot.variables[v]] = v;
+        snapshot.variable_names.push_back(manager.getTopVarName(snapshot.variables[v]));
+    }
+
+    /* Ascending IDs, so the successors of a node already have their position */
+    snapshot.nodes.reserve(ids.size());
+    for (const auto f : ids) {
+        positions[f] = snapshot.nodes.size();
+        if (manager.isConstant(f)) {
+            snapshot.nodes.push_back({f, bdd_snapshot_t::NO_VARIABLE, 0, 0});
+        } else {
+            snapshot.nodes.push_back({f, levels.at(manager.topVar(f)), positions.at(manager.coFactorTrue(f)),
+                                      positions.at(manager.coFactorFalse(f))});
+        }
+    }
+
+    snapshot.root_labels = root_labels;
+    auto *hashing_manager = dynamic_cast<ClassProject::Manager *>(&manager);
+    for (const auto root : roots) {
+        snapshot.roots.push_back(positions.at(root));
+        snapshot.root_hashes.push_back((hashing_manager != nullptr) ? hashing_manager->structuralHash(root) : 0);
+    }
+}
+
+const bdd_snapshot_t &BddWriter::GetSnapshot() const {
+    return snapshot;
+}
+
+std::vector<size_t> BddWriter::AllNodes() const {
+    std::vector<size_t> nodes(snapshot.nodes.size());
+    for (size_t n = 0; n < nodes.size(); n++) {
+        nodes[n] = n;
+    }
+    return nodes;
+}
+
+std::vector<size_t> BddWriter::ReachableNodes(size_t root, std::vector<size_t> &visited, size_t mark) const {
+    std::vector<size_t> reachable;
+    std::vector<size_t> stack{root};
+    while (!stack.empty()) {
+        size_t n = stack.back();
+        stack.pop_back();
+        if (visited[n] == mark) continue;
+        visited[n] = mark;
+        reachable.push_back(n);
+        if (snapshot.nodes[n].variable != bdd_snapshot_t::NO_VARIABLE) {
+            stack.push_back(snapshot.nodes[n].high);
+            stack.push_back(snapshot.nodes[n].low);
+        }
+    }
+    std::sort(reachable.begin(), reachable.end());
+    return reachable;
+}
+
+void BddWriter::RenderText(const std::vector<size_t> &nodes, std::string &out) const {
+    for (auto it = nodes.rbegin(); it != nodes.rend(); ++it) {
+        const bdd_snapshot_node_t &node = snapshot.nodes[*it];
+        if (node.variable == bdd_snapshot_t::NO_VARIABLE) {
+            out += "Terminal Node: ";
+            AppendNumber(out, node.id);
+        } else {
+            out += "Variable Node: ";
+            AppendNumber(out, node.id);
+            out += " Top Var Id: ";
+            AppendNumber(out, snapshot.variables[node.variable]);
+            out += " Top Var Name: ";
+            out += snapshot.variable_names[node.variable];
+            out += " Low: ";
+            AppendNumber(out, snapshot.nodes[node.low].id);
+            out += " High: ";
+            AppendNumber(out, snapshot.nodes[node.high].id);
+        }
+        out += '\n';
+    }
+}
+
+void BddWriter::RenderDot(const std::vector<size_t> &nodes, const std::vector<size_t> &roots,
+                          std::string &out) const {
+    /* Bucket the inner nodes by level, the sort is stable so every rank stays in ascending ID order */
+    std::vector<size_t> by_level;
+    for (const auto n : nodes) {
+        if (snapshot.nodes[n].variable != bdd_snapshot_t::NO_VARIABLE) by_level.push_back(n);
+    }
+    std::stable_sort(by_level.begin(), by_level.end(), [&](size_t a, size_t b) {
+        return snapshot.nodes[a].variable < snapshot.nodes[b].variable;
+    });
+
+    out += "digraph BDD {\n";
+    out += "center = true;\n";
+    out += "{ rank = same; { node [style=invis]; \"T\" };\n";
+    out += " { node [shape=box,fontsize=12]; \"0\"; }\n";
+    out += "  { node [shape=box,fontsize=12]; \"1\"; }\n}\n";
+    std::vector<size_t> levels;
+    for (size_t i = 0; i < by_level.size();) {
+        size_t variable = snapshot.nodes[by_level[i]].variable;
+        levels.push_back(variable);
+        out += R"({ rank=same; { node [shape=plaintext,fontname="Times Italic",fontsize=12] ")";
+        out += snapshot.variable_names[variable];
+        out += "\" };";
+        for (; i < by_level.size() && snapshot.nodes[by_level[i]].variable == variable; i++) {
+            out += '"';
+            AppendNumber(out, snapshot.nodes[by_level[i]].id);
+            out += "\";";
+        }
+        out += "}\n";
+    }
+    out += "edge [style = invis]; {";
+    for (const auto variable : levels) {
+        out += '"';
+        out += snapshot.variable_names[variable];
+        out += "\" -> ";
+    }
+    out += "\"T\"; }\n";
+    for (const auto n : nodes) {
+        const bdd_snapshot_node_t &node = snapshot.nodes[n];
+        if (node.variable == bdd_snapshot_t::NO_VARIABLE) continue;
+        out += '"';
+        AppendNumber(out, node.id);
+        out += "\" -> \"";
+        AppendNumber(out, snapshot.nodes[node.high].id);
+        out += "\" [style=solid,arrowsize=\".75\"];\n\"";
+        AppendNumber(out, node.id);
+        out += "\" -> \"";
+        AppendNumber(out, snapshot.nodes[node.low].id);
+        out += "\" [style=dashed,arrowsize=\".75\"];\n";
+    }
+    for (const auto r : roots) {
+        out += "\"r";
+        AppendNumber(out, r);
+        out += "\" [shape=plaintext,label=\"";
+        out += snapshot.root_labels[r];
+        out += "\"];\n\"r";
+        AppendNumber(out, r);
+        out += "\" -> \"";
+        AppendNumber(out, snapshot.nodes[snapshot.roots[r]].id);
+        out += "\" [style=solid];\n";
+    }
+    out += "}\n";
+}
+
+void BddWriter::RenderBinary(const std::vector<size_t> &nodes, const std::vector<size_t> &roots,
+                             std::string &out) const {
+    /* Only the variables of these nodes are stored, both are renumbered to their position in the file */
+    std::vector<size_t> variables;
+    for (const auto n : nodes) {
+        if (snapshot.nodes[n].variable != bdd_snapshot_t::NO_VARIABLE) variables.push_back(snapshot.nodes[n].variable);
+    }
+    std::sort(variables.begin(), variables.end());
+    variables.erase(std::unique(variables.begin(), variables.end()), variables.end());
+    auto position = [](const std::vector<size_t> &sorted, size_t value) -> uint64_t {
+        return std::lower_bound(sorted.begin(), sorted.end(), value) - sorted.begin();
+    };
+
+    out.append(BINARY_MAGIC, sizeof(BINARY_MAGIC));
+    AppendWord(out, variables.size());
+    AppendWord(out, nodes.size());
+    AppendWord(out, roots.size());
+    for (const auto variable : variables) {
+        AppendWord(out, snapshot.variables[variable]);
+        AppendName(out, snapshot.variable_names[variable]);
+    }
+    for (const auto n : nodes) {
+        const bdd_snapshot_node_t &node = snapshot.nodes[n];
+        AppendWord(out, node.id);
+        if (node.variable == bdd_snapshot_t::NO_VARIABLE) {
+            AppendWord(out, bdd_snapshot_t::NO_VARIABLE);
+            AppendWord(out, 0);
+            AppendWord(out, 0);
+        } else {
+            AppendWord(out, position(variables, node.variable));
+            AppendWord(out, position(nodes, node.high));
+            AppendWord(out, position(nodes, node.low));
+        }
+    }
+    for (const auto r : roots) {
+        AppendWord(out, position(nodes, snapshot.roots[r]));
+        AppendName(out, snapshot.root_labels[r]);
+        AppendWord(out, snapshot.root_hashes[r]);
+    }
+}
+
+void BddWriter::WriteNodes(const std::vector<size_t> &nodes, const std::vector<size_t> &roots,
+                           const std::string &result_dir, const std::string &name, unsigned int formats,
+                           bool combined, std::string &buffer) const {
+    if (formats & TEXT_FORMAT) {
+        buffer.clear();
+        if (combined) {
+            for (const auto r : roots) {
+                buffer += "Root: ";
+                buffer += snapshot.root_labels[r];
+                buffer += " Node: ";
+                AppendNumber(buffer, snapshot.nodes[snapshot.roots[r]].id);
+                if (snapshot.root_hashes[r] != 0) {
+                    buffer += " Hash: ";
+                    AppendHash(buffer, snapshot.root_hashes[r]);
+                }
+                buffer += '\n';
+            }
+        } else if (snapshot.root_hashes[roots.front()] != 0) {
+            buffer += "Hash: ";
+            AppendHash(buffer, snapshot.root_hashes[roots.front()]);
+            buffer += '\n';
+        }
+        RenderText(nodes, buffer);
+        WriteFile(result_dir + "/txt/" + name + ".txt", buffer);
+    }
+    if (formats & DOT_FORMAT) {
+        buffer.clear();
+        RenderDot(nodes, combined ? roots : std::vector<size_t>{}, buffer);
+        WriteFile(result_dir + "/dot/" + name + ".dot", buffer);
+    }
+    if (formats & BINARY_FORMAT) {
+        buffer.clear();
+        RenderBinary(nodes, roots, buffer);
+        WriteFile(result_dir + "/bin/" + name + ".bdd", buffer);
+    }
+}
+
+void BddWriter::WriteFile(const std::string &file_name, const std::string &content) {
+    std::ofstream file(file_name, std::ios::binary);
+    if (!file.is_open()) {
+        throw std::runtime_error("Unable to open " + file_name + "!");
+    }
+    file.write(content.data(), static_cast<std::streamsize>(content.size()));
+    if (!file) {
+        throw std::runtime_error("Unable to write " + file_name + "!");
+    }
+}
+
+void BddWriter::CreateDirectories(const std::string &result_dir, unsigned int formats) {
+    for (const auto &format : {std::make_pair(TEXT_FORMAT, "/txt"), std::make_pair(DOT_FORMAT, "/dot"),
+                               std::make_pair(BINARY_FORMAT, "/bin")}) {
+        std::string directory = result_dir + format.second;
+        if ((formats & format.first) && !std::filesystem::exists(directory) &&
+            !std::filesystem::create_directory(directory)) {
+            throw std::runtime_error("Unable to create directory '" + directory + "' for the output!");
+        }
+    }
+}
+
+void BddWriter::WriteRoots(const std::string &result_dir, unsigned int threads, unsigned int formats) const {
+    threads = std::max(1u, std::min<unsigned int>(threads, static_cast<unsigned int>(snapshot.roots.size())));
+
+    /* Workers take the next root until all are written, each with scratch space of its own */
+    std::atomic<size_t> next{0};
+    std::vector<std::exception_ptr> errors(threads);
+    auto work = [&](unsigned int w) {
+        ClassProject::TraceSpan span("writeRoots", "print", w);
+        try {
+            std::vector<size_t> visited(snapshot.nodes.size(), SIZE_MAX);
+            std::string buffer;
+            for (size_t r = next++; r < snapshot.roots.size(); r = next++) {
+                std::vector<size_t> nodes = ReachableNodes(snapshot.roots[r], visited, r);
+                WriteNodes(nodes, {r}, result_dir, snapshot.root_labels[r], formats, false, buffer);
+            }
+        } catch (...) {
+            errors[w] = std::current_exception();
+        }
+    };
+
+    std::vector<std::thread> workers;
+    for (unsigned int w = 1; w < threads; w++) {
+        workers.emplace_back(work, w);
+    }
+    work(0);
+    for (auto &worker : workers) {
+        worker.join();
+    }
+    for (const auto &error : errors) {
+        if (error) std::rethrow_exception(error);
+    }
+}
+
+void BddWriter::WriteCombined(const std::string &result_dir, const std::string &name, unsigned int formats) const {
+    std::vector<size_t> roots(snapshot.roots.size());
+    for (size_t r = 0; r < roots.size(); r++) {
+        roots[r] = r;
+    }
+    std::string buffer;
+    ClassProject::TraceSpan span("writeCombined", "print", static_cast<int64_t>(roots.size()));
+    WriteNodes(AllNodes(), roots, result_dir, name, formats, true, buffer);
+}
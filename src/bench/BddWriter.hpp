@@ -0,0 +1,196 @@
+//
+// Batched writing of the BDDs of many outputs
+//
+
+#pragma once
+
+#include "Circuit.hpp"
+#include "../Manager.h"
+
+#include <string>
+#include <vector>
+
+/**
+ * \enum bdd_format_t
+ * \brief Formats BddWriter can write, combined as a bit mask.
+ */
+enum bdd_format_t : unsigned int {
+    TEXT_FORMAT = 1,   ///< txt/<label>.txt, one line per node, read by the verify_tool
+    DOT_FORMAT = 2,    ///< dot/<label>.dot, for graphviz
+    BINARY_FORMAT = 4, ///< bin/<label>.bdd, see BddWriter
+    ALL_FORMATS = TEXT_FORMAT | DOT_FORMAT | BINARY_FORMAT
+};
+
+/**
+ * \struct bdd_snapshot_node_t
+ * \brief Node of a bdd_snapshot_t, children are referenced by their position in the snapshot.
+ */
+typedef struct bdd_snapshot_node_t {
+    ClassProject::BDD_ID id; ///< BDD_ID of the node in the manager
+    size_t variable;         ///< Position of the top variable in bdd_snapshot_t::variables, NO_VARIABLE for terminals
+    size_t high;             ///< Position of the high successor
+    size_t low;              ///< Position of the low successor
+} bdd_snapshot_node_t;
+
+/**
+ * \struct bdd_snapshot_t
+ * \brief Plain copy of the nodes reachable from a set of labeled roots, independent of the manager.
+ */
+typedef struct bdd_snapshot_t {
+    static constexpr size_t NO_VARIABLE = SIZE_MAX;
+
+    std::vector<bdd_snapshot_node_t> nodes;        ///< Ascending by BDD_ID, so children come before their parents
+    std::vector<ClassProject::BDD_ID> variables;   ///< Top variables of the nodes, ascending, i.e. by level
+    std::vector<label_t> variable_names;           ///< Name of each variable
+    std::vector<label_t> root_labels;              ///< Label of each root
+    std::vector<size_t> roots;                     ///< Position of each root in nodes
+    std::vector<uint64_t> root_hashes;             ///< ClassProject::Manager::structuralHash of each root, 0 if unknown
+} bdd_snapshot_t;
+
+/**
+ * \class BddWriter
+ *
+ * \brief Writes the BDDs of many outputs in text, dot or binary format from one shared traversal.
+ *
+ *  The constructor visits every node below the requested roots once and copies it into a
+ *   bdd_snapshot_t, so writing needs no more calls to the manager and may run on another
+ *   thread while the manager changes. Each file is rendered into one string with the nodes
+ *   bucketed by level and written with a single call.
+ *
+ *  If the manager is a ClassProject::Manager, the structural hash of every root is written as
+ *   well, so the dumps of two runs can be compared by their hashes alone. A text file then starts
+ *   with a "Hash: <16 hex digits>" line.
+ *
+ *  A binary file holds little-endian 64-bit words: the 8 bytes of BINARY_MAGIC, the number of
+ *   variables, nodes and roots, then every variable as its ID and name, every node in ascending
+ *   ID order as its ID, variable, high and low, and every root as its node, label and hash. Names
+ *   are a length followed by the characters. Variables and nodes are referenced by their position
+ *   in the file, terminals have the variable NO_VARIABLE.
+ */
+class BddWriter {
+private:
+    bdd_snapshot_t snapshot;
+
+    /**
+     * \brief return the positions of the nodes reachable from one root, ascending.
+     * \param root is the position of the root in the snapshot
+     * \param visited is scratch space of one entry per snapshot node, entries equal to mark count as visited
+     * \param mark is a value not used in visited before
+     * \return std::vector<size_t>
+     */
+    std::vector<size_t> ReachableNodes(size_t root, std::vector<size_t> &visited, size_t mark) const;
+
+    /**
+     * \brief returns the positions of all nodes of the snapshot.
+     * \param none
+     * \return std::vector<size_t>
+     */
+    std::vector<size_t> AllNodes() const;
+
+    /**
+     * \brief renders nodes in the text format, highest ID first.
+     * \param nodes are positions in the snapshot, ascending
+     * \param out is the string to append to
+     * \return none
+     */
+    void RenderText(const std::vector<size_t> &nodes, std::string &out) const;
+
+    /**
+     * \brief renders nodes in the dot format, with one rank per variable.
+     * \param nodes are positions in the snapshot, ascending
+     * \param roots are the roots to draw a labeled arrow to, by index into bdd_snapshot_t::roots, empty for none
+     * \param out is the string to append to
+     * \return none
+     */
+    void RenderDot(const std::vector<size_t> &nodes, const std::vector<size_t> &roots, std::string &out) const;
+
+    /**
+     * \brief renders nodes in the binary format.
+     * \param nodes are positions in the snapshot, ascending and closed under successors
+     * \param roots are the roots to store, by index into bdd_snapshot_t::roots, their nodes must be part of nodes
+     * \param out is the string to append to
+     * \return none
+     */
+    void RenderBinary(const std::vector<size_t> &nodes, const std::vector<size_t> &roots, std::string &out) const;
+
+    /**
+     * \brief renders and writes the requested formats of some nodes.
+     * \param nodes are positions in the snapshot, ascending and closed under successors
+     * \param roots are the roots, by index into bdd_snapshot_t::roots
+     * \param result_dir is the directory holding the txt, dot and bin directories
+     * \param name is the file name without extension
+     * \param formats is a mask of bdd_format_t
+     * \param combined lists the roots in the text and dot file as well, see WriteCombined
+     * \param buffer is reused for rendering
+     * \return none
+     */
+    void WriteNodes(const std::vector<size_t> &nodes, const std::vector<size_t> &roots, const std::string &result_dir,
+                    const std::string &name, unsigned int formats, bool combined, std::string &buffer) const;
+
+    /**
+     * \brief writes a string to a file with one call.
+     * \param file_name is the path of the file, it is overwritten
+     * \param content is the data to write
+     * \return none
+     *
+     * \throws std::runtime_error if the file cannot be written
+     */
+    static void WriteFile(const std::string &file_name, const std::string &content);
+
+public:
+    static constexpr char BINARY_MAGIC[8] = {'V', 'D', 'S', 'B', 'D', 'D', '0', '2'}; ///< First bytes of a binary file
+
+    /**
+     * \brief Constructor, copies the BDDs of the roots out of the manager.
+     * \param manager is the manager holding the BDDs
+     * \param root_labels are the names of the roots, used as file names
+     * \param roots are the BDDs to write, one per label
+     */
+    BddWriter(ClassProject::ManagerInterface &manager, const std::vector<label_t> &root_labels,
+              const std::vector<ClassProject::BDD_ID> &roots);
+
+    /**
+     * \brief return the copied BDDs.
+     * \param none
+     * \return const bdd_snapshot_t&
+     */
+    const bdd_snapshot_t &GetSnapshot() const;
+
+    /**
+     * \brief Creates the txt, dot and bin directories of the requested formats.
+     * \param result_dir is the directory to create them in, it must exist
+     * \param formats is a mask of bdd_format_t
+     * \return none
+     *
+     * \throws std::runtime_error if a directory cannot be created
+     */
+    static void CreateDirectories(const std::string &result_dir, unsigned int formats);
+
+    /**
+     * \brief Writes every root to txt/<label>.txt, dot/<label>.dot and bin/<label>.bdd below a directory.
+     * \param result_dir is the directory, see CreateDirectories
+     * \param threads is the number of threads rendering and writing files
+     * \param formats is a mask of bdd_format_t
+     * \return none
+     *
+     * \throws std::runtime_error if a file cannot be written
+     */
+    void WriteRoots(const std::string &result_dir, unsigned int threads = 1,
+                    unsigned int formats = TEXT_FORMAT | DOT_FORMAT) const;
+
+    /**
+     * \brief Writes all roots into one file per format below a directory, e.g. txt/<name>.txt.
+     * \param result_dir is the directory, see CreateDirectories
+     * \param name is the file name without extension
+     * \param formats is a mask of bdd_format_t
+     * \return none
+     *
+     *  Shared nodes are written once. The text file starts with one "Root: <label> Node: <id>"
+     *   line per root, followed by " Hash: <16 hex digits>" if the hash is known. The dot file draws
+     *   an arrow from each label to its root.
+     *
+     * \throws std::runtime_error if a file cannot be written
+     */
+    void WriteCombined(const std::string &result_dir, const std::string &name,
+                       unsigned int formats = TEXT_FORMAT | DOT_FORMAT) const;
+};
@@ -0,0 +1,151 @@
+//
+// Combinational equivalence checking of two bench files
+//
+
+#include "BenchEquivalence.hpp"
+#include "CircuitSimulator.hpp"
+
+
+BenchEquivalence::BenchEquivalence(BenchParser &first, BenchParser &second, size_t simulation_words)
+        : circuits{&first, &second} {
+
+    manager = make_shared<ClassProject::Manager>();
+
+    /* INPUT gates of both circuits are mapped by label onto shared variables, in the order of the first one */
+    for (const auto parsed_circuit : circuits) {
+        const Circuit &circuit = parsed_circuit->GetSortedCircuit();
+        for (const auto &node : circuit.GetNodes()) {
+            if (node.gate_type == gate_type_t::INPUT && bindings.count(circuit.GetLabel(node.id)) == 0) {
+                bindings[circuit.GetLabel(node.id)] = manager->createVar(circuit.GetLabel(node.id));
+            }
+        }
+    }
+
+    /* Both circuits see the same patterns on inputs of the same label */
+    CircuitSimulator first_simulator(first.GetSortedCircuit(), simulation_words);
+    CircuitSimulator second_simulator(second.GetSortedCircuit(), simulation_words);
+    std::array<const CircuitSimulator *, 2> simulators{&first_simulator, &second_simulator};
+
+    for (const auto &candidate : CircuitSimulator::GetEquivalenceCandidates({&first_simulator, &second_simulator})) {
+        cut_class_t cut_class{manager->False(), false, NO_BDD, {}};
+
+        /* A class containing an INPUT is cut to its variable, a constant class to False */
+        size_t anchor = candidate.nodes.size();
+        for (size_t i = 0; i < candidate.nodes.size() && anchor == candidate.nodes.size(); i++) {
+            const Circuit &circuit = circuits[candidate.circuits[i]]->GetSortedCircuit();
+            if (circuit.GetNodes()[candidate.nodes[i]].gate_type == gate_type_t::INPUT) anchor = i;
+        }
+        const uint64_t *values = simulators[candidate.circuits[0]]->GetValues(candidate.nodes[0]);
+        bool constant = true;
+        for (size_t w = 0; w < first_simulator.GetPatternCount() / 64; w++) {
+            constant = constant && (values[w] == 0 || values[w] == ~uint64_t(0)) && values[w] == values[0];
+        }
+
+        for (size_t i = 0; i < candidate.nodes.size(); i++) {
+            const Circuit &circuit = circuits[candidate.circuits[i]]->GetSortedCircuit();
+            if (circuit.GetNodes()[candidate.nodes[i]].gate_type == gate_type_t::INPUT) continue;
+
+            bool complemented = candidate.complemented[i];
+            if (anchor < candidate.nodes.size()) {
+                complemented = complemented != candidate.complemented[anchor];
+            } else if (constant) {
+                complemented = simulators[candidate.circuits[i]]->GetValues(candidate.nodes[i])[0] & 1;
+            }
+            cut_class.members.push_back({candidate.circuits[i], candidate.nodes[i], complemented});
+        }
+
+        if (anchor < candidate.nodes.size()) {
+            const Circuit &circuit = circuits[candidate.circuits[anchor]]->GetSortedCircuit();
+            cut_class.variable = bindings.at(circuit.GetLabel(candidate.nodes[anchor]));
+            cut_class.reference = cut_class.variable;
+        } else if (constant) {
+            cut_class.reference = manager->False();
+        } else {
+            if (cut_class.members.size() < 2) continue;
+            cut_class.variable = manager->createVar("cut_" + std::to_string(cut_classes.size()));
+            cut_class.fresh = true;
+        }
+        if (!cut_class.members.empty()) cut_classes.push_back(std::move(cut_class));
+    }
+}
+
+bool BenchEquivalence::ProveCut(size_t circuit, unique_ID_t id, ClassProject::BDD_ID function) {
+    const auto &member = member_classes[circuit].at(id);
+    cut_class_t &cut_class = cut_classes[member.first];
+    if (member.second) function = manager->neg(function);
+
+    /* A fresh variable stands for the function of the first member built, the others must compute the
+     *  same, either directly or from the cut point itself, e.g. a NOT of another member */
+    if (cut_class.reference == NO_BDD) {
+        cut_class.reference = function;
+    } else if (function != cut_class.reference && function != cut_class.variable) {
+        return false;
+    }
+    proved_cuts++;
+    return true;
+}
+
+bool BenchEquivalence::CheckOutputWithoutCuts(const label_t &label) {
+    std::array<ClassProject::BDD_ID, 2> outputs{};
+    for (size_t c = 0; c < circuits.size(); c++) {
+        CircuitToBDD circuit2BDD(manager);
+        circuit2BDD.SetInputVariables(bindings);
+        circuit2BDD.SetSelectedOutputs({label});
+        circuit2BDD.BuildBDD(circuits[c]->GetSortedCircuit());
+        outputs[c] = circuit2BDD.GetBddId(label);
+    }
+    return outputs[0] == outputs[1];
+}
+
+equivalence_result_t BenchEquivalence::Check() {
+    equivalence_result_t result;
+    proved_cuts = 0;
+    for (auto &cut_class : cut_classes) {
+        if (cut_class.fresh) cut_class.reference = NO_BDD;
+    }
+
+    /* One build per circuit, every cut is proved by the time its users are built. The first circuit is
+     *  built first, so the functions of its gates are the references of the classes they share */
+    for (size_t c = 0; c < circuits.size(); c++) {
+        std::unordered_map<unique_ID_t, ClassProject::BDD_ID> cut_points;
+        for (size_t k = 0; k < cut_classes.size(); k++) {
+            for (const auto &member : cut_classes[k].members) {
+                if (member.circuit == c) {
+                    cut_points[member.id] = member.complemented ? manager->neg(cut_classes[k].variable)
+                                                                : cut_classes[k].variable;
+                    member_classes[c][member.id] = {k, member.complemented};
+                }
+            }
+        }
+
+        builders[c] = make_unique<CircuitToBDD>(manager);
+        builders[c]->SetInputVariables(bindings);
+        builders[c]->SetCutPoints(cut_points);
+        builders[c]->SetCutCheck([this, c](unique_ID_t id, ClassProject::BDD_ID function) {
+            return ProveCut(c, id, function);
+        });
+        builders[c]->BuildBDD(circuits[c]->GetSortedCircuit());
+    }
+    result.cut_points = proved_cuts;
+
+    std::set<label_t> outputs = circuits[0]->GetListOfOutputLabels();
+    const std::set<label_t> &second_outputs = circuits[1]->GetListOfOutputLabels();
+    outputs.insert(second_outputs.begin(), second_outputs.end());
+
+    for (const auto &label : outputs) {
+        if (circuits[0]->GetListOfOutputLabels().count(label) == 0 || second_outputs.count(label) == 0) {
+            result.missing.push_back(label);
+        } else if (builders[0]->GetBddId(label) == builders[1]->GetBddId(label) ||
+                   (result.cut_points > 0 && CheckOutputWithoutCuts(label))) {
+            result.equivalent.push_back(label);
+        } else {
+            result.different.push_back(label);
+        }
+    }
+
+    return result;
+}
+
+shared_ptr<ClassProject::Manager> BenchEquivalence::GetManager() {
+    return manager;
+}
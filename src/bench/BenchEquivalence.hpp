@@ -0,0 +1,115 @@
+//
+// Combinational equivalence checking of two bench files
+//
+
+#pragma once
+
+#include "BenchParser.hpp"
+#include "CircuitToBDD.hpp"
+
+#include <array>
+#include <memory>
+
+
+/**
+ * \struct equivalence_result_t
+ * \brief Outcome of BenchEquivalence::Check, by output label.
+ */
+typedef struct equivalence_result_t {
+    std::vector<label_t> equivalent; ///< Outputs with the same function in both circuits
+    std::vector<label_t> different;  ///< Outputs with different functions
+    std::vector<label_t> missing;    ///< Outputs of only one of the circuits
+    size_t cut_points = 0;           ///< Gates replaced by a proved cut point
+} equivalence_result_t;
+
+/**
+ * \class BenchEquivalence
+ *
+ * \brief Class to check two circuits for equivalence in one manager
+ *
+ *  Primary inputs and FLIP FLOP outputs of the same label share one variable, so the
+ *   outputs of both circuits are equivalent exactly if their BDD_IDs are equal. Gates that
+ *   have equal or complementary values in a random simulation of both circuits are replaced
+ *   by a common cut point variable, which keeps the BDDs of the gates behind them small.
+ *   Both circuits are built once, in topological order. A gate is only cut once the BDD it
+ *   computes with the earlier cuts equals the function of its class, the first gate of a
+ *   class defines that function. Outputs that still differ are compared once more without
+ *   cut points, as cut points can hide an equivalence.
+ *
+ */
+class BenchEquivalence {
+
+public:
+
+    /**
+     * \brief Creates the shared variables and finds the cut point candidates of two parsed circuits
+     * \param first is the first parsed bench file, its INPUT order decides the variable order
+     * \param second is the second parsed bench file
+     * \param simulation_words is the number of 64 pattern words simulated to find cut point candidates
+     */
+    BenchEquivalence(BenchParser &first, BenchParser &second, size_t simulation_words = 16);
+
+    /**
+     * \brief Builds both circuits and compares their outputs
+     * \param none
+     * \return equivalence_result_t
+     */
+    equivalence_result_t Check();
+
+    /**
+     * \brief Returns the manager holding the BDDs of both circuits
+     * \param none
+     * \return shared_ptr<ClassProject::Manager>
+     */
+    shared_ptr<ClassProject::Manager> GetManager();
+
+private:
+
+    /**
+     * \struct cut_member_t
+     * \brief Gate replaced by a cut point.
+     */
+    typedef struct cut_member_t {
+        size_t circuit;     ///< 0 for the first circuit, 1 for the second
+        unique_ID_t id;     ///< Circuit ID of the gate
+        bool complemented;  ///< True if the gate computes the complement of the cut point
+    } cut_member_t;
+
+    /**
+     * \struct cut_class_t
+     * \brief Gates sharing one cut point.
+     */
+    typedef struct cut_class_t {
+        ClassProject::BDD_ID variable; ///< BDD the gates are replaced by
+        bool fresh;                    ///< True if variable was created for the class, false for an INPUT or constant
+        ClassProject::BDD_ID reference; ///< Function the members must compute, NO_BDD until the first fresh cut
+        std::vector<cut_member_t> members;
+    } cut_class_t;
+
+    static constexpr ClassProject::BDD_ID NO_BDD = SIZE_MAX; ///< Marks a class without a reference yet
+
+    std::array<BenchParser *, 2> circuits;
+    std::array<std::unique_ptr<CircuitToBDD>, 2> builders;
+    shared_ptr<ClassProject::Manager> manager;
+    std::unordered_map<label_t, ClassProject::BDD_ID> bindings; ///< Variables shared by INPUT label
+    std::vector<cut_class_t> cut_classes;
+    /// Cut class and complement flag of every member, by circuit
+    std::array<std::unordered_map<unique_ID_t, std::pair<size_t, bool>>, 2> member_classes;
+    size_t proved_cuts = 0; ///< Gates cut by the current Check
+
+    /**
+     * \brief Decides whether a gate is replaced by the cut point of its class
+     * \param circuit is 0 for the first circuit, 1 for the second
+     * \param id is the circuit ID of a member of a cut class
+     * \param function is the BDD the gate computes with the earlier cuts
+     * \return true if the function proves the cut
+     */
+    bool ProveCut(size_t circuit, unique_ID_t id, ClassProject::BDD_ID function);
+
+    /**
+     * \brief Compares one output of both circuits built without cut points
+     * \param label is the output label
+     * \return true if the output is equivalent
+     */
+    bool CheckOutputWithoutCuts(const label_t &label);
+};
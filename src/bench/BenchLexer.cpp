@@ -0,0 +1,237 @@
+//
+// Hand-written lexer for the ISCAS85/89/99 bench format
+//
+
+#include "BenchLexer.hpp"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cstring>
+#include <stdexcept>
+
+/* ----------------
+ * Label table
+ * ----------------
+ */
+
+label_id_t LabelTable::Intern(std::string_view label) {
+    auto got = label_ids.find(label);
+    if (got != label_ids.end()) {
+        return got->second;
+    }
+
+    auto new_id = static_cast<label_id_t>(labels.size());
+    labels.emplace_back(label);
+    label_ids.emplace(labels.back(), new_id);
+    return new_id;
+}
+
+label_id_t LabelTable::Find(std::string_view label) const {
+    auto got = label_ids.find(label);
+    return (got != label_ids.end()) ? got->second : NO_LABEL;
+}
+
+const label_t &LabelTable::GetLabel(label_id_t id) const {
+    return labels.at(id);
+}
+
+size_t LabelTable::Size() const {
+    return labels.size();
+}
+
+/* ----------------
+ * Gate types
+ * ----------------
+ */
+
+const char *GateTypeName(gate_type_t gate_type) {
+    switch (gate_type) {
+        case gate_type_t::INPUT:     return "INPUT";
+        case gate_type_t::OUTPUT:    return "OUTPUT";
+        case gate_type_t::FLIP_FLOP: return "DFF";
+        case gate_type_t::BUFFER:    return "BUFF";
+        case gate_type_t::NOT:       return "NOT";
+        case gate_type_t::AND:       return "AND";
+        case gate_type_t::OR:        return "OR";
+        case gate_type_t::NAND:      return "NAND";
+        case gate_type_t::NOR:       return "NOR";
+        case gate_type_t::XOR:       return "XOR";
+        case gate_type_t::CONST0:    return "CONST0";
+        case gate_type_t::CONST1:    return "CONST1";
+    }
+    return "UNKNOWN";
+}
+
+/* ----------------
+ * Lexer
+ * ----------------
+ */
+
+namespace {
+    bool IsLabelChar(char c) {
+        return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') || c == '_' || c == '.';
+    }
+
+    bool IsBlank(char c) {
+        return c == ' ' || c == '\t' || c == '\r';
+    }
+
+    void SkipBlanks(std::string_view line, size_t &i) {
+        while (i < line.size() && IsBlank(line[i])) i++;
+    }
+
+    /* Reads a token of label characters, an empty view if there is none */
+    std::string_view ReadLabel(std::string_view line, size_t &i) {
+        SkipBlanks(line, i);
+        size_t start = i;
+        while (i < line.size() && IsLabelChar(line[i])) i++;
+        return line.substr(start, i - start);
+    }
+
+    bool Expect(std::string_view line, size_t &i, char c) {
+        SkipBlanks(line, i);
+        if (i < line.size() && line[i] == c) {
+            i++;
+            return true;
+        }
+        return false;
+    }
+
+    /* Maps the keyword of a gate with inputs to its type, false if it is not one */
+    bool ReadGateType(std::string_view keyword, gate_type_t &gate_type) {
+        static const gate_type_t gates[] = {gate_type_t::FLIP_FLOP, gate_type_t::BUFFER, gate_type_t::NOT,
+                                            gate_type_t::AND, gate_type_t::OR, gate_type_t::NAND,
+                                            gate_type_t::NOR, gate_type_t::XOR};
+        for (auto gate : gates) {
+            if (keyword == GateTypeName(gate)) {
+                gate_type = gate;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    bool IsSingleInputGate(gate_type_t gate_type) {
+        return gate_type == gate_type_t::NOT || gate_type == gate_type_t::BUFFER ||
+               gate_type == gate_type_t::FLIP_FLOP;
+    }
+}
+
+BenchLexer::BenchLexer(const std::string &bench_file, LabelTable &labels) : label_table(labels) {
+    int fd = open(bench_file.c_str(), O_RDONLY);
+    if (fd < 0) {
+        throw std::runtime_error("Could not open file: " + bench_file);
+    }
+
+    struct stat file_stat{};
+    if (fstat(fd, &file_stat) != 0) {
+        close(fd);
+        throw std::runtime_error("Could not open file: " + bench_file);
+    }
+
+    size = static_cast<size_t>(file_stat.st_size);
+    if (size > 0) {
+        void *mapping = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (mapping == MAP_FAILED) {
+            close(fd);
+            throw std::runtime_error("Could not map file: " + bench_file);
+        }
+        /* The file is read once from front to back */
+        madvise(mapping, size, MADV_SEQUENTIAL);
+        data = static_cast<const char *>(mapping);
+    }
+    close(fd);
+
+    pos = data;
+}
+
+BenchLexer::~BenchLexer() {
+    if (data != nullptr) {
+        munmap(const_cast<char *>(data), size);
+    }
+}
+
+bool BenchLexer::Next(bench_line_t &statement) {
+    const char *end = data + size;
+
+    while (pos < end) {
+        const char *line_end = static_cast<const char *>(memchr(pos, '\n', end - pos));
+        if (line_end == nullptr) {
+            line_end = end;
+        }
+        std::string_view line(pos, line_end - pos);
+        pos = (line_end < end) ? line_end + 1 : end;
+        line_number++;
+
+        /* Skip blank lines and comments */
+        size_t i = 0;
+        SkipBlanks(line, i);
+        if (i == line.size() || line[i] == '#') {
+            continue;
+        }
+
+        if (!ParseLine(line, statement)) {
+            throw std::runtime_error("line " + std::to_string(line_number) + ": " + std::string(line));
+        }
+        return true;
+    }
+
+    return false;
+}
+
+bool BenchLexer::ParseLine(std::string_view line, bench_line_t &statement) {
+    size_t i = 0;
+    statement.inputs.clear();
+
+    std::string_view first = ReadLabel(line, i);
+    if (first.empty()) {
+        return false;
+    }
+
+    if (Expect(line, i, '(')) {
+        /* Primary inputs and outputs: INPUT(label), OUTPUT(label) */
+        if (first == "INPUT") {
+            statement.gate_type = gate_type_t::INPUT;
+        } else if (first == "OUTPUT") {
+            statement.gate_type = gate_type_t::OUTPUT;
+        } else {
+            return false;
+        }
+        std::string_view label = ReadLabel(line, i);
+        if (label.empty() || !Expect(line, i, ')')) {
+            return false;
+        }
+        statement.label = label_table.Intern(label);
+    } else {
+        /* Gates: label = TYPE(input, ...) */
+        if (!Expect(line, i, '=')) {
+            return false;
+        }
+        statement.label = label_table.Intern(first);
+        if (!ReadGateType(ReadLabel(line, i), statement.gate_type) || !Expect(line, i, '(')) {
+            return false;
+        }
+        do {
+            std::string_view input = ReadLabel(line, i);
+            if (input.empty()) {
+                return false;
+            }
+            statement.inputs.push_back(label_table.Intern(input));
+        } while (Expect(line, i, ','));
+        if (!Expect(line, i, ')')) {
+            return false;
+        }
+
+        /* Same arities as the original grammar: one input for NOT/BUFF/DFF, at least two for the others */
+        if (IsSingleInputGate(statement.gate_type) ? statement.inputs.size() != 1 : statement.inputs.size() < 2) {
+            return false;
+        }
+    }
+
+    /* Only a trailing comment may follow */
+    SkipBlanks(line, i);
+    return i == line.size() || line[i] == '#';
+}
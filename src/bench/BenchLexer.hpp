@@ -0,0 +1,158 @@
+//
+// Hand-written lexer for the ISCAS85/89/99 bench format
+//
+
+#pragma once
+
+#include <cstdint>
+#include <deque>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+typedef std::string label_t;  ///< Type definition for labels
+typedef uint32_t label_id_t;  ///< Type definition for interned labels
+
+constexpr label_id_t NO_LABEL = UINT32_MAX; ///< Marks an unused label ID
+
+/**
+ * \enum gate_type_t
+ * \brief Gate types of the ISCAS85/89/99 bench format.
+ *
+ *  CONST0 and CONST1 are not part of the format, they are only created by CircuitStrash.
+ */
+enum class gate_type_t : uint8_t {
+    INPUT,
+    OUTPUT,
+    FLIP_FLOP,
+    BUFFER,
+    NOT,
+    AND,
+    OR,
+    NAND,
+    NOR,
+    XOR,
+    CONST0,
+    CONST1
+};
+
+/**
+ * \brief return the keyword of a gate type as written in bench files, e.g. "NAND".
+ * \param gate_type is gate_type_t
+ * \return const char*
+ */
+const char *GateTypeName(gate_type_t gate_type);
+
+/**
+ * \class LabelTable
+ *
+ * \brief Symbol table that interns node labels into dense IDs.
+ *
+ *  Each distinct label is stored exactly once, IDs are assigned in order of
+ *  first appearance starting at zero.
+ */
+class LabelTable {
+private:
+    std::deque<label_t> labels;                                 ///< Storage with stable addresses for the views below
+    std::unordered_map<std::string_view, label_id_t> label_ids; ///< Mapping from label to its ID
+
+public:
+    LabelTable() = default;
+
+    /* The views in label_ids point into labels, so a table must not be copied */
+    LabelTable(const LabelTable &) = delete;
+
+    LabelTable &operator=(const LabelTable &) = delete;
+
+    /**
+     * \brief return the ID of a label, assigning a new ID if it is not interned yet.
+     * \param label is std::string_view
+     * \return label_id_t
+     */
+    label_id_t Intern(std::string_view label);
+
+    /**
+     * \brief return the ID of an already interned label.
+     * \param label is std::string_view
+     * \return label_id_t, NO_LABEL if the label is unknown
+     */
+    label_id_t Find(std::string_view label) const;
+
+    /**
+     * \brief return the label of an interned ID.
+     * \param id is label_id_t
+     * \return const label_t&
+     */
+    const label_t &GetLabel(label_id_t id) const;
+
+    /**
+     * \brief return the number of interned labels.
+     * \param none
+     * \return size_t
+     */
+    size_t Size() const;
+};
+
+/**
+ * \struct bench_line_t
+ * \brief One statement of a bench file, e.g. "G3 = NAND(G1, G2)" or "INPUT(G1)".
+ *
+ *  For INPUT and OUTPUT statements the label is the argument and the input list is empty.
+ */
+typedef struct bench_line_t {
+    label_id_t label;                ///< Interned label of the node
+    gate_type_t gate_type;           ///< Type of the gate (ex. AND, NOT, OR)
+    std::vector<label_id_t> inputs;  ///< Interned labels of all inputs of the gate
+} bench_line_t;
+
+/**
+ * \class BenchLexer
+ *
+ * \brief Reads a bench file line by line without copying it.
+ *
+ *  The file is memory mapped, tokens are string views into the mapping and
+ *  labels are interned into a LabelTable as they are read.
+ */
+class BenchLexer {
+private:
+    const char *data = nullptr; ///< Start of the mapped file
+    size_t size = 0;            ///< Size of the mapped file
+    const char *pos = nullptr;  ///< Current read position
+    size_t line_number = 0;     ///< Number of the line read last, for error messages
+
+    LabelTable &label_table;
+
+    /**
+     * \brief parses a single line into a statement.
+     * \param line is the line without its line ending
+     * \param statement receives the parsed statement
+     * \return bool returns true if the line is a statement, false if it is a syntax error
+     */
+    bool ParseLine(std::string_view line, bench_line_t &statement);
+
+public:
+    /**
+     * \brief Constructor, maps the file into memory.
+     * \param bench_file the path to the benchmark file
+     * \param labels the table the labels are interned into
+     *
+     * \throws std::runtime_error if the file cannot be opened
+     */
+    BenchLexer(const std::string &bench_file, LabelTable &labels);
+
+    ~BenchLexer();
+
+    BenchLexer(const BenchLexer &) = delete;
+
+    BenchLexer &operator=(const BenchLexer &) = delete;
+
+    /**
+     * \brief reads the next statement, skipping empty lines and comments.
+     * \param statement receives the parsed statement
+     * \return bool returns false at the end of the file
+     *
+     * \throws std::runtime_error on a syntax error, reporting the line
+     */
+    bool Next(bench_line_t &statement);
+};
@@ -4,29 +4,43 @@
 //
 
 #include "BenchParser.hpp"
+#include "../Trace.h"
 
-BenchParser::BenchParser(const std::string &bench_file) {
+#include <algorithm>
+#include <queue>
 
-    id_counter = 0;
+BenchParser::BenchParser(const std::string &bench_file)
+        : label_table(std::make_shared<LabelTable>()), circuit(label_table) {
 
-    if (parseFile(bench_file)) {
+    bool parsed;
+    {
+        ClassProject::TraceSpan span("parseFile", "parse");
+        parsed = parseFile(bench_file);
+    }
+    if (parsed) {
         /* Based on the list of output labels, generate the corresponding circuit */
         std::cout << "- Creating circuit from bench nodes... ";
-        createCircuitFromOutputList();
+        {
+            ClassProject::TraceSpan span("createCircuit", "parse");
+            createCircuitFromOutputList();
+        }
         std::cout << "Done!" << std::endl;
 
         /* Sort the circuit */
         std::cout << "- Topologically sorting the circuit... ";
-        TopologicalSortKahnsAlgorithm();
+        {
+            ClassProject::TraceSpan span("topologicalSort", "parse");
+            TopologicalSortKahnsAlgorithm();
+        }
         std::cout << "Done!" << std::endl;
 
-        label_to_node.clear();
-        labels_to_id.clear();
-        id_to_circuit_node.clear();
+        std::vector<bench_node_t>().swap(label_to_node);
+        std::vector<unique_ID_t>().swap(labels_to_id);
+        std::vector<size_t>().swap(preorder_keys);
+        std::vector<bool>().swap(preorder_on_stack);
+        preorder_roots.clear();
         output_labels.clear();
         ff_labels.clear();
-        output_circuits.clear();
-        input_circuits.clear();
     } else {
         throw std::runtime_error("Please check bench file syntax!");
     }
@@ -34,44 +48,83 @@ BenchParser::BenchParser(const std::string &bench_file) {
 
 BenchParser::~BenchParser() = default;
 
+/* ---------------
+ * Node keys
+ * ---------------
+ */
+BenchParser::node_role_t BenchParser::NodeRole(gate_type_t gate_type) {
+    switch (gate_type) {
+        case gate_type_t::OUTPUT:
+            return OUTPUT_NODE;
+        case gate_type_t::FLIP_FLOP:
+            return FLIP_FLOP_NODE;
+        default:
+            return GATE_NODE;
+    }
+}
+
+size_t BenchParser::NodeKey(label_id_t label, node_role_t role) {
+    return static_cast<size_t>(label) * NUMBER_OF_ROLES + role;
+}
+
+void BenchParser::SortLabels(std::vector<label_id_t> &labels) {
+    std::sort(labels.begin(), labels.end(), [this](label_id_t a, label_id_t b) {
+        return label_table->GetLabel(a) < label_table->GetLabel(b);
+    });
+    labels.erase(std::unique(labels.begin(), labels.end()), labels.end());
+}
+
+size_t BenchParser::InputCount(const bench_node_t &bench_node) {
+    return (bench_node.gate_type == gate_type_t::OUTPUT) ? 1 : bench_node.input_node_list.size();
+}
+
+size_t BenchParser::InputKey(const bench_node_t &bench_node, size_t input) {
+    if (bench_node.gate_type == gate_type_t::OUTPUT) {
+        return NodeKey(bench_node.label, GATE_NODE);
+    }
+    return NodeKey(bench_node.input_node_list[input], GATE_NODE);
+}
+
+unique_ID_t BenchParser::InputId(const bench_node_t &bench_node, size_t input) {
+    return labels_to_id[InputKey(bench_node, input)];
+}
+
 /* --------------- 
  * Print Functions 
  * ---------------
  */
 void BenchParser::PrintLabelsTable() {
-    std::unordered_map<label_t, bench_node_t>::const_iterator it_label;
-
     std::cout << "============ [BEGIN] Table of Labels and Nodes ============" << std::endl;
     std::cout << std::endl << "-----" << std::endl;
-    for (it_label = label_to_node.begin(); it_label != label_to_node.end(); it_label++) {
-        std::cout << std::endl << "Label: " << it_label->first << std::endl;
+    for (const auto &bench_node : label_to_node) {
+        if (bench_node.label == NO_LABEL)
+            continue;
+        std::cout << std::endl << "Label: " << label_table->GetLabel(bench_node.label) << std::endl;
         std::cout << "Node Information:" << std::endl;
-        std::cout << "\tNode Label: " << it_label->second.label << std::endl;
-        std::cout << "\tGate Type: " << it_label->second.gate_type << std::endl;
+        std::cout << "\tNode Label: " << label_table->GetLabel(bench_node.label) << std::endl;
+        std::cout << "\tGate Type: " << GateTypeName(bench_node.gate_type) << std::endl;
         std::cout << "\tInputs: ";
-        for (const auto &i : it_label->second.input_node_list)
-            std::cout << i << ' ';
+        for (const auto &i : bench_node.input_node_list)
+            std::cout << label_table->GetLabel(i) << ' ';
         std::cout << std::endl << "-----" << std::endl;
     }
     std::cout << "============ [END] Table of Labels and Nodes ============" << std::endl;
 }
 
 void BenchParser::PrintUUIDCircuitTable() {
-    std::unordered_map<unique_ID_t, circuit_node_t>::const_iterator it_uuid;
-
     std::cout << "============ [BEGIN] Table of Labels and Nodes ============" << std::endl;
     std::cout << std::endl << "-----" << std::endl;
-    for (it_uuid = id_to_circuit_node.begin(); it_uuid != id_to_circuit_node.end(); it_uuid++) {
-        std::cout << std::endl << "UUID: " << it_uuid->first << std::endl;
+    for (const auto &node : circuit.GetNodes()) {
+        std::cout << std::endl << "UUID: " << node.id << std::endl;
         std::cout << "Node Information:" << std::endl;
-        std::cout << "\tNode Circuit Label: " << it_uuid->second.label << std::endl;
-        std::cout << "\tGate Type: " << it_uuid->second.gate_type << std::endl;
+        std::cout << "\tNode Circuit Label: " << label_table->GetLabel(node.label) << std::endl;
+        std::cout << "\tGate Type: " << GateTypeName(node.gate_type) << std::endl;
         std::cout << "\tInputs: ";
-        for (unsigned long i : it_uuid->second.input_id_list)
+        for (unsigned long i : circuit.GetFanins(node.id))
             std::cout << i << ' ';
         std::cout << std::endl << "-----" << std::endl;
         std::cout << "\tOutputs: ";
-        for (unsigned long i : it_uuid->second.output_id_list)
+        for (unsigned long i : circuit.GetFanouts(node.id))
             std::cout << i << ' ';
         std::cout << std::endl << "-----" << std::endl;
     }
@@ -79,63 +132,60 @@ void BenchParser::PrintUUIDCircuitTable() {
 }
 
 void BenchParser::PrintOutputList() {
-    std::set<label_t>::const_iterator it;
-
     std::cout << std::endl << "============ [BEGIN] List of Outputs ============" << std::endl << std::endl;
     std::cout << std::endl << "List of output labels: ";
-    for (it = output_labels.begin(); it != output_labels.end(); it++) {
-        std::cout << (*it) << " -> ";
+    for (const auto &output_label : output_labels) {
+        std::cout << label_table->GetLabel(output_label) << " -> ";
     }
     std::cout << "end;" << std::endl;
     std::cout << std::endl << "============ [END] List of Outputs ============" << std::endl;
 }
 
 void BenchParser::PrintLabels2UUIDTable() {
-    std::unordered_map<label_t, unique_ID_t>::const_iterator it_label;
-
     std::cout << "============ [BEGIN] Table of Labels and UUIDs ============" << std::endl;
     std::cout << std::endl << "-----" << std::endl;
-    for (it_label = labels_to_id.begin(); it_label != labels_to_id.end(); it_label++) {
-        std::cout << std::endl << "Label: " << it_label->first << std::endl;
-        std::cout << std::endl << "UUID: " << it_label->second << std::endl;
+    for (size_t key = 0; key < labels_to_id.size(); key++) {
+        if (labels_to_id[key] == NO_CIRCUIT)
+            continue;
+        std::cout << std::endl << "Label: " << label_table->GetLabel(key / NUMBER_OF_ROLES);
+        if (key % NUMBER_OF_ROLES != GATE_NODE)
+            std::cout << ((key % NUMBER_OF_ROLES == OUTPUT_NODE) ? " (OUTPUT)" : " (DFF)");
+        std::cout << std::endl;
+        std::cout << std::endl << "UUID: " << labels_to_id[key] << std::endl;
         std::cout << std::endl << "------------------------------" << std::endl;
     }
     std::cout << "============ [END] Table of Labels and UUIDs ============" << std::endl;
 }
 
 void BenchParser::PrintCircuit(unique_ID_t circuit_ID, int indent) {
-    std::unordered_map<unique_ID_t, circuit_node_t>::const_iterator got;
-    circuit_node_t node;
-
-    got = (id_to_circuit_node).find(circuit_ID);
-    if (got != id_to_circuit_node.end()) {
-        node = got->second;
+    if (circuit_ID < circuit.Size()) {
+        const circuit_node_t &node = circuit.GetNodes()[circuit_ID];
         std::cout << std::string(indent, ' ') << "Node ID: " << node.id << std::endl;
-        std::cout << std::string(indent, ' ') << "Label: " << node.label << std::endl;
-        std::cout << std::string(indent, ' ') << "Type: " << node.gate_type << std::endl;
+        std::cout << std::string(indent, ' ') << "Label: " << label_table->GetLabel(node.label) << std::endl;
+        std::cout << std::string(indent, ' ') << "Type: " << GateTypeName(node.gate_type) << std::endl;
 
         std::cout << std::string(indent, ' ') << "Input List: " << std::endl;
-        for (unsigned long i : node.input_id_list)
+        for (unsigned long i : circuit.GetFanins(node.id))
             std::cout << std::string(indent, ' ') << "    " << i << std::endl;
 
         std::cout << std::string(indent, ' ') << "Output List: " << std::endl;
-        for (unsigned long i : node.output_id_list)
+        for (unsigned long i : circuit.GetFanouts(node.id))
             std::cout << std::string(indent, ' ') << "    " << i << std::endl;
 
         indent = indent + 4;
         std::cout << std::string(indent, ' ') << "--------------" << std::endl;
-        for (unsigned long i : node.input_id_list)
+        for (unsigned long i : circuit.GetFanins(node.id))
             PrintCircuit(i, indent);
         std::cout << std::string(indent, ' ') << "--------------" << std::endl;
     }
 }
 
 void BenchParser::PrintCircuitByLabel(const label_t &node_label) {
-    std::unordered_map<label_t, unique_ID_t>::const_iterator got;
+    label_id_t label = label_table->Find(node_label);
+    size_t key = NodeKey(label, GATE_NODE);
 
-    got = (labels_to_id).find(node_label);
-    if (got != labels_to_id.end()) {
-        PrintCircuit(got->second, 0);
+    if (label != NO_LABEL && key < labels_to_id.size() && labels_to_id[key] != NO_CIRCUIT) {
+        PrintCircuit(labels_to_id[key], 0);
     } else {
         throw std::runtime_error("There is no mapping from this label to a circuit node.");
     }
@@ -144,23 +194,18 @@ void BenchParser::PrintCircuitByLabel(const label_t &node_label) {
 
 
 void BenchParser::PrintCircuitsOfOutputSet() {
-    for (unsigned long it : output_circuits) {
+    for (unsigned long it : circuit.GetRoots()) {
         PrintCircuit(it, 0);
     }
 }
 
 void BenchParser::PrintSortedCircuitList() {
-    list_of_circuit_t::const_iterator it;
-
     std::cout << std::endl << "============ [BEGIN] List of Sorted Circuit Nodes ============" << std::endl
               << std::endl;
     std::cout << std::endl << "List of Sorted Circuit Nodes labels: ";
 
-    list_of_circuit_t ordered_circuit = this->GetSortedCircuit();
-
-
-    for (it = ordered_circuit.begin(); it != ordered_circuit.end(); it++) {
-        std::cout << (*it).id << " -> ";
+    for (const auto &node : circuit.GetNodes()) {
+        std::cout << node.id << " -> ";
     }
     std::cout << "end;" << std::endl;
     std::cout << std::endl << "============ [END] List of Sorted Circuit Nodes ============" << std::endl;
@@ -171,41 +216,20 @@ void BenchParser::PrintSortedCircuitList() {
  * ----------------
  */
 
-set_of_circuit_t BenchParser::GetListOfCircuitsInputs() {
-    return input_circuits;
-}
-
-
-set_of_circuit_t BenchParser::GetListOfCircuitsOutputs() {
-    return output_circuits;
-}
-
-std::set<label_t> BenchParser::GetListOfOutputLabels() {
+const std::set<label_t> &BenchParser::GetListOfOutputLabels() {
     return outputs;
 }
 
-
-circuit_node_t BenchParser::GetCircuitNode(unique_ID_t circuit_node_uuid) {
-    /* Iterator for the uuid2circuitNode_table table */
-    std::unordered_map<unique_ID_t, circuit_node_t>::const_iterator got;
-
-    /* Search the node and add the UUID of the current node to this node OUTPUT_LIST */
-    got = id_to_circuit_node.find(circuit_node_uuid);
-
-    if (got != id_to_circuit_node.end()) {
-        return got->second;
-    }//if
-    else {
-        throw std::runtime_error("There is no mapping from this unique_ID_t to a circuit_node_type.");
-    }
+const std::vector<std::pair<label_t, label_t>> &BenchParser::GetListOfFlipFlops() {
+    return flip_flops;
 }
 
-std::unordered_map<unique_ID_t, circuit_node_t> BenchParser::GetCircuit() {
-    return id_to_circuit_node;
+const std::set<label_t> &BenchParser::GetListOfPrimaryInputLabels() {
+    return primary_inputs;
 }
 
-list_of_circuit_t BenchParser::GetSortedCircuit() {
-    return sorted_circuit;
+const Circuit &BenchParser::GetSortedCircuit() {
+    return circuit;
 }
 
 /* --------------- 
@@ -215,39 +239,33 @@ list_of_circuit_t BenchParser::GetSortedCircuit() {
 bool BenchParser::parseFile(const std::string &bench_file) {
 
     std::cout << std::endl << "- Reading bench format file... ";
-    std::ifstream in(bench_file);
-    if (!in.is_open()) {
-        throw std::runtime_error("Could not open file: " + bench_file);
-    }
-    in.unsetf(std::ios::skipws);
+    BenchLexer lexer(bench_file, *label_table);
     std::cout << "Done!" << std::endl;
 
-    /* Declaring file iterators */
-    boost::spirit::istream_iterator first(in), last;
-
-    /* Declaring skip parser to be used */
-    skip_p::skip_grammar<boost::spirit::istream_iterator> skip;
-
-    /* Declaring bench format grammar */
-    bench_format::bench_parser<boost::spirit::istream_iterator> bench_grammar_parser;
-
     /* Stored result after parsing a file line */
-    bench_format::bench_node_type parsed_bench_node;
+    bench_line_t statement;
+    bench_node_t parsed_bench_node;
 
-    /* Effectively parsing the file. The parser returns a benchnode to be added to the labels table */
+    /* Effectively parsing the file. Every statement is converted to a bench node and added to the labels table */
     std::cout << "- Parsing input file '" << bench_file << "'... ";
-    bool successfully_parsed;
-    do {
-        successfully_parsed = phrase_parse(first, last, bench_grammar_parser, skip, parsed_bench_node);
-        if (!successfully_parsed) {
-            std::cout << "Failed parsing input file at: " << std::string(first, last) << std::endl;
-            return false;
-        } else {
-            /* Add the successfully read bench node into the labels table */
+    bool any_statement = false;
+    try {
+        while (lexer.Next(statement)) {
+            parsed_bench_node.label = statement.label;
+            parsed_bench_node.gate_type = statement.gate_type;
+            parsed_bench_node.input_node_list.swap(statement.inputs);
+
             addToLabelTable(parsed_bench_node);
+            any_statement = true;
         }
-        parsed_bench_node = bench_format::bench_node_type();
-    } while (first != last); /* Operations are performed until it is EOF */
+    } catch (const std::runtime_error &error) {
+        std::cout << "Failed parsing input file at " << error.what() << std::endl;
+        return false;
+    }
+    if (!any_statement) {
+        std::cout << "Failed parsing input file: no statements found" << std::endl;
+        return false;
+    }
     std::cout << "Done!" << std::endl;
 
     return true;
@@ -255,167 +273,141 @@ bool BenchParser::parseFile(const std::string &bench_file) {
 
 
 bool BenchParser::addToLabelTable(bench_node_t bench_node) {
-    bool new_node_added;
-    label_t search_label;
     /*
      * Output nodes have to be handle a bit different, since they'll have
-     *  the same label as another gate. Mappings require unique element
-     *  identifiers. By convention, OUTPUT gates will be referenced by its
-     *  original label concatenated with the string "OUTPUT" to differentiate
-     *  from the other gate that has the same label.
+     *  the same label as another gate. They are stored under the OUTPUT
+     *  role of their label to differentiate them from the other gate
+     *  that has the same label.
     */
-    if (bench_node.gate_type == OUTPUT_GATE_T) {
-        /* If the gate is an output gate, it must be included into the set_of_output_labels */
-        output_labels.insert(bench_node.label);
-        search_label = bench_node.label + bench_node.gate_type;
-    } else {
-        search_label = bench_node.label;
+    node_role_t search_role = GATE_NODE;
+    if (bench_node.gate_type == gate_type_t::OUTPUT) {
+        /* If the gate is an output gate, it must be included into the list of output labels */
+        output_labels.push_back(bench_node.label);
+        search_role = OUTPUT_NODE;
     }
 
-    if (label_to_node.find(search_label) != label_to_node.end()) {
-        new_node_added = false;
-    } else {
-        /*
-         * Otherwise add bench_node to the labels_table
-         */
-        if (bench_node.gate_type == FLIP_FLOP_GATE_T) {
-
-            /* If it is a flip flop, we have to add two nodes:
-               One that will be the output node;
-               Another one as input node.
-               For the searching part it is not necessary to differentiate it,
-               since for each existing flip flop in the circuit we will add
-               to the labels table one node that is an INPUT with the same
-               label as the flip flop, and another one with the "FLIP_FLOP_GATE_T"
-               string concatenated. So if we search for one of them, it is
-               enough to check whether the node exists or not. */
-            ff_labels.insert(search_label);
-            label_to_node.insert(std::pair<label_t, bench_node_t>(search_label + FLIP_FLOP_GATE_T, bench_node));
-            bench_node.gate_type = INPUT_GATE_T;
-            bench_node.input_node_list.clear();
-        }
-        label_to_node.insert(std::pair<label_t, bench_node_t>(search_label, bench_node));
-        new_node_added = true;
+    /* Labels are interned while lexing, so the table grows along with the label table */
+    if (label_to_node.size() < label_table->Size() * NUMBER_OF_ROLES) {
+        label_to_node.resize(label_table->Size() * NUMBER_OF_ROLES);
     }
-    return new_node_added;
-}
-
-unique_ID_t BenchParser::findOrAddToCircuit(const bench_node_t &bench_node) {
-
-    unique_ID_t CircuitNodeID;
-    std::unordered_map<label_t, unique_ID_t>::const_iterator got;
-    circuit_node_t new_circuit_node;
-    label_t search_label;
 
-    if ((bench_node.gate_type == OUTPUT_GATE_T) || (bench_node.gate_type == FLIP_FLOP_GATE_T)) {
-        search_label = bench_node.label + bench_node.gate_type;
-    } else {
-        search_label = bench_node.label;
+    size_t search_key = NodeKey(bench_node.label, search_role);
+    if (label_to_node[search_key].label != NO_LABEL) {
+        return false;
     }
 
-    got = labels_to_id.find(search_label);
-
-    if (got != labels_to_id.end()) {
-        /* If the iterator is not pointing to the end of the labels_table,
-           means that already exist another node with the same label. Then
-           simply returns the unique ID from the node. */
-        CircuitNodeID = (got->second);
-    } else {
-        /*
-         * Otherwise add bench_node to the labels_table and returns its UUID
-         */
-        new_circuit_node = benchNodeToCircuitNode(bench_node);
-        CircuitNodeID = new_circuit_node.id;
-        labels_to_id.insert(std::pair<label_t, unique_ID_t>(search_label, CircuitNodeID));
-        id_to_circuit_node.insert(std::pair<unique_ID_t, circuit_node_t>(CircuitNodeID, new_circuit_node));
-    }
-    return CircuitNodeID;
-}
-
-
-unique_ID_t BenchParser::findOrAddToCircuitByLabel(const label_t &node_label) {
-
-    auto label = (label_to_node).find(node_label);
-
-    if (label != label_to_node.end()) {
-        return (findOrAddToCircuit(label->second));
-    } else {
-        throw std::runtime_error("There is no mapping from this label to a node.");
+    /*
+     * Otherwise add bench_node to the labels_table
+     */
+    if (bench_node.gate_type == gate_type_t::FLIP_FLOP) {
+
+        /* If it is a flip flop, we have to add two nodes:
+           One that will be the output node;
+           Another one as input node.
+           For the searching part it is not necessary to differentiate it,
+           since for each existing flip flop in the circuit we will add
+           to the labels table one node that is an INPUT with the same
+           label as the flip flop, and another one under the FLIP FLOP
+           role. So if we search for one of them, it is enough to check
+           whether the node exists or not. */
+        ff_labels.push_back(bench_node.label);
+        label_to_node[NodeKey(bench_node.label, FLIP_FLOP_NODE)] = bench_node;
+        bench_node.gate_type = gate_type_t::INPUT;
+        bench_node.input_node_list.clear();
     }
+    label_to_node[search_key] = std::move(bench_node);
+    return true;
 }
 
-circuit_node_t BenchParser::benchNodeToCircuitNode(const bench_node_t &bench_node) {
-
-    circuit_node_t new_circuit_node;
-    size_t input_id, new_id;
-
-    /* Generate an unique identifier */
-    new_circuit_node.id = id_counter;
-    id_counter++;
-    new_id = new_circuit_node.id;
-
-    new_circuit_node.label = bench_node.label;
-    new_circuit_node.gate_type = bench_node.gate_type;
-
-    /* If it is not an INPUT gate, we have to recursively iterate to get the unique id of the inputs */
-    if (!(new_circuit_node.gate_type == INPUT_GATE_T)) {
+unique_ID_t BenchParser::findOrAddToCircuitByLabel(label_id_t node_label, node_role_t role) {
 
-        if (new_circuit_node.gate_type == OUTPUT_GATE_T) {
+    size_t root_key = NodeKey(node_label, role);
 
-            input_id = findOrAddToCircuitByLabel(bench_node.label);
-            new_circuit_node.input_id_list.insert(input_id);
-
-            auto node = id_to_circuit_node.find(input_id);
-            if (node != id_to_circuit_node.end()) {
-                node->second.output_id_list.insert(new_id);
-            }
-
-        } else {
+    if (root_key >= label_to_node.size() || label_to_node[root_key].label == NO_LABEL) {
+        throw std::runtime_error("There is no mapping from the label " + label_table->GetLabel(node_label) +
+                                 " to a node.");
+    }
+    if (labels_to_id[root_key] != NO_CIRCUIT) {
+        /* If there is an ID for the key, means that the node was already
+           added to the circuit. Then simply returns its unique ID. */
+        return labels_to_id[root_key];
+    }
 
-            for (const auto &input_node : bench_node.input_node_list) {
+    /* Depth first search with an explicit stack of (node key, next input), so deep circuits
+       cannot overflow the call stack. Nodes get their ID when they are reached */
+    std::vector<std::pair<size_t, size_t>> stack;
+    labels_to_id[root_key] = preorder_keys.size();
+    preorder_keys.push_back(root_key);
+    preorder_on_stack.push_back(true);
+    stack.emplace_back(root_key, 0);
+
+    while (!stack.empty()) {
+        size_t key = stack.back().first;
+        size_t next_input = stack.back().second;
+        const bench_node_t &bench_node = label_to_node[key];
+
+        if (next_input == InputCount(bench_node)) {
+            preorder_on_stack[labels_to_id[key]] = false;
+            stack.pop_back();
+            continue;
+        }
 
-                input_id = findOrAddToCircuitByLabel(input_node);
-                new_circuit_node.input_id_list.insert(input_id);
+        stack.back().second++;
+        size_t input_key = InputKey(bench_node, next_input);
 
-                auto node = id_to_circuit_node.find(input_id);
-                if (node != id_to_circuit_node.end()) {
-                    node->second.output_id_list.insert(new_id);
-                }
-            }
+        if (input_key >= label_to_node.size() || label_to_node[input_key].label == NO_LABEL) {
+            throw std::runtime_error("There is no mapping from the label " +
+                                     label_table->GetLabel(static_cast<label_id_t>(input_key / NUMBER_OF_ROLES)) +
+                                     " to a node.");
+        }
+        if (labels_to_id[input_key] == NO_CIRCUIT) {
+            labels_to_id[input_key] = preorder_keys.size();
+            preorder_keys.push_back(input_key);
+            preorder_on_stack.push_back(true);
+            stack.emplace_back(input_key, 0);
+        } else if (preorder_on_stack[labels_to_id[input_key]]) {
+            throw std::runtime_error("The circuit must be cycle free!");
         }
-    } else {
-        input_circuits.insert(new_id);
     }
 
-    return new_circuit_node;
+    return labels_to_id[root_key];
 }
 
-
 void BenchParser::createCircuitFromOutputList() {
 
-    std::set<label_t>::const_iterator it;
-    std::unordered_map<label_t, unique_ID_t>::const_iterator got_uid;
-    std::unordered_map<unique_ID_t, circuit_node_t>::const_iterator got_node;
+    /* Outputs are built in the order of their names, as the variable order depends on it */
+    SortLabels(output_labels);
+    SortLabels(ff_labels);
+    labels_to_id.assign(label_to_node.size(), NO_CIRCUIT);
 
     for (const auto &output_label : output_labels) {
-        createCircuitByLabel(output_label + OUTPUT_GATE_T);
+        createCircuitByLabel(output_label, OUTPUT_NODE);
     }
     for (const auto &ff_label : ff_labels) {
-        createCircuitByLabel(ff_label + FLIP_FLOP_GATE_T);
+        createCircuitByLabel(ff_label, FLIP_FLOP_NODE);
     }
+
     for (const auto &ff_label : ff_labels) {
-        auto ff_id = labels_to_id.find(ff_label + FLIP_FLOP_GATE_T);
-        auto ff_node = id_to_circuit_node.find(ff_id->second);
-        ff_node = id_to_circuit_node.find(*(ff_node->second).input_id_list.begin());
-        outputs.insert(ff_node->second.label);
+        const bench_node_t &ff_node = label_to_node[NodeKey(ff_label, FLIP_FLOP_NODE)];
+        const label_t &next_state_label = label_table->GetLabel(ff_node.input_node_list.front());
+        outputs.insert(next_state_label);
+        flip_flops.emplace_back(label_table->GetLabel(ff_label), next_state_label);
+    }
+    for (const auto &output_label : output_labels) {
+        outputs.insert(label_table->GetLabel(output_label));
+    }
+
+    for (const auto &key : preorder_keys) {
+        const bench_node_t &bench_node = label_to_node[key];
+        if (bench_node.gate_type == gate_type_t::INPUT &&
+            labels_to_id[NodeKey(bench_node.label, FLIP_FLOP_NODE)] == NO_CIRCUIT) {
+            primary_inputs.insert(label_table->GetLabel(bench_node.label));
+        }
     }
-    outputs.insert(output_labels.begin(), output_labels.end());
 }
 
-void BenchParser::createCircuitByLabel(const label_t &bnode_label) {
-    unique_ID_t new_circuit;
-    new_circuit = findOrAddToCircuitByLabel(bnode_label);
-    output_circuits.insert(new_circuit);
+void BenchParser::createCircuitByLabel(label_id_t bnode_label, node_role_t role) {
+    preorder_roots.push_back(findOrAddToCircuitByLabel(bnode_label, role));
 }
 
 
@@ -424,51 +416,66 @@ void BenchParser::createCircuitByLabel(const label_t &bnode_label) {
  * -----------------------------
  */
 void BenchParser::TopologicalSortKahnsAlgorithm() {
-    set_of_circuit_t nodes_without_outgoing_edges = GetListOfCircuitsOutputs();
-    set_of_circuit_t::iterator it;
+    size_t node_count = preorder_keys.size();
+
+    /* Number of outputs of every node that are not taken yet */
+    std::vector<size_t> pending_outputs(node_count, 0);
+    for (const auto &key : preorder_keys) {
+        const bench_node_t &bench_node = label_to_node[key];
+        for (size_t i = 0; i < InputCount(bench_node); i++) {
+            pending_outputs[InputId(bench_node, i)]++;
+        }
+    }
 
-    circuit_node_t node, tmp_node;
+    /* Always pick the node with the smallest pre-order ID among the nodes without outgoing edges */
+    std::priority_queue<unique_ID_t, std::vector<unique_ID_t>, std::greater<>> nodes_without_outgoing_edges(
+            std::greater<>(), preorder_roots);
+
+    /* Nodes are taken from the outputs towards the inputs, so they are stored from the back */
+    std::vector<unique_ID_t> sorted_ids(node_count);
+    size_t position = node_count;
 
     while (!nodes_without_outgoing_edges.empty()) {
-        it = nodes_without_outgoing_edges.begin();
-        /* Always pick the first element of the list of nodes without incoming edges */
-        node = GetCircuitNode(*it);
-        nodes_without_outgoing_edges.erase(it);
-
-        /* Nodes are added always to the end of the list */
-        sorted_circuit.push_front(node);
-        for (auto it_input_nodes = node.input_id_list.begin();
-             it_input_nodes != node.input_id_list.end(); it_input_nodes++) {
-            if (IsUniqueOutgoingEdge(*it_input_nodes, node.id)) {
-                nodes_without_outgoing_edges.insert(*it_input_nodes);
+        unique_ID_t node = nodes_without_outgoing_edges.top();
+        nodes_without_outgoing_edges.pop();
+        sorted_ids[--position] = node;
+
+        const bench_node_t &bench_node = label_to_node[preorder_keys[node]];
+        for (size_t i = 0; i < InputCount(bench_node); i++) {
+            unique_ID_t input = InputId(bench_node, i);
+            if (--pending_outputs[input] == 0) {
+                nodes_without_outgoing_edges.push(input);
             }
         }
     }
 
-    if (sorted_circuit.size() != id_to_circuit_node.size()) {
+    if (position != 0) {
         throw std::runtime_error("The circuit must be cycle free!");
     }
-}
-
-
-/* -----------------------------
- * Auxiliary functions for
- * Topological Sort Algorithms
- * -----------------------------
- */
 
-bool BenchParser::IsUniqueOutgoingEdge(unique_ID_t src_node, unique_ID_t dst_node) {
-    std::unordered_map<unique_ID_t, circuit_node_t>::iterator got;
+    /* The position in the sorted order becomes the circuit ID */
+    std::vector<unique_ID_t> sorted_position(node_count);
+    for (size_t i = 0; i < node_count; i++) {
+        sorted_position[sorted_ids[i]] = i;
+    }
 
-    /* Search source node in the circuit graph */
-    got = id_to_circuit_node.find(src_node);
+    std::vector<unique_ID_t> fanin_ids;
+    for (const auto &node : sorted_ids) {
+        const bench_node_t &bench_node = label_to_node[preorder_keys[node]];
+        fanin_ids.clear();
+        for (size_t i = 0; i < InputCount(bench_node); i++) {
+            fanin_ids.push_back(sorted_position[InputId(bench_node, i)]);
+        }
+        /* Inputs in ascending order, the order the gates are built in */
+        std::sort(fanin_ids.begin(), fanin_ids.end());
+        circuit.AddNode(bench_node.label, bench_node.gate_type, fanin_ids);
+    }
+    for (const auto &root : preorder_roots) {
+        circuit.AddRoot(sorted_position[root]);
+    }
+    circuit.Finalize();
 
-    if (got != id_to_circuit_node.end()) {
-        /* Remove outgoing edge to source node */
-        (got->second).output_id_list.erase((got->second).output_id_list.find(dst_node));
-        return (got->second).output_id_list.empty();
-    }//if
-    else {
-        throw std::runtime_error("Destination node UUID is not part of the circuit graph!");
+    for (const auto &key : preorder_keys) {
+        labels_to_id[key] = sorted_position[labels_to_id[key]];
     }
 }
@@ -5,50 +5,27 @@
 
 #pragma once
 
-#include "skip_parser.hpp"
-#include "bench_grammar.hpp"
+#include "BenchLexer.hpp"
+#include "Circuit.hpp"
 #include <fstream>
 
-#include <boost/algorithm/string.hpp>
-
-#include <unordered_map>
+#include <memory>
+#include <set>
 #include <stdexcept>
 
 #include "BenchmarkLib.h"
 
 
-#define OUTPUT_GATE_T    "OUTPUT"
-#define INPUT_GATE_T     "INPUT"
-#define FLIP_FLOP_GATE_T "DFF"
-#define BUFFER_GATE_T    "BUFF"
-#define NOT_GATE_T       "NOT"
-#define AND_GATE_T       "AND"
-#define OR_GATE_T        "OR"
-#define NAND_GATE_T      "NAND"
-#define NOR_GATE_T       "NOR"
-#define XOR_GATE_T       "XOR"
-
-/* Type definitions */
-typedef std::string label_t;                        ///< Type definition for labels
-typedef bench_format::bench_node_type bench_node_t; ///< Type definition for a node of the ISCAS85/89/99 bench format
-typedef size_t unique_ID_t;             ///< Type definition for unique identifiers for circuits
-typedef std::set<size_t> set_of_circuit_t;     ///< Type definition for set of circuits
-
 /**
- * \struct circuit_node_type
- * \brief Struct that represents a node from a circuit. 
+ * \struct bench_node_t
+ * \brief Struct that represents a node of the ISCAS85/89/99 bench format.
  *
  */
-typedef struct circuit_node_t {
-    size_t id;                  ///< Unique ID for a node
-    std::string label;               ///< Node Label
-    std::string gate_type;           ///< Type of the gate (ex. AND, NOT, OR)
-    std::set<size_t> input_id_list;  ///< set containing all the inputs of the respective gate
-    std::set<size_t> output_id_list; ///< set containing all the outputs of the respective gate
-} circuit_node_t;
-
-typedef std::list<circuit_node_t> list_of_circuit_t; ///< Type definition for list of circuits
-
+typedef struct bench_node_t {
+    label_id_t label = NO_LABEL;              ///< Interned label of the node, NO_LABEL for an unused entry
+    gate_type_t gate_type = gate_type_t::INPUT; ///< Type of the gate (ex. AND, NOT, OR)
+    std::vector<label_id_t> input_node_list;  ///< list containing the interned labels of all inputs of the gate
+} bench_node_t;
 
 /**
  * \class BenchParser
@@ -63,26 +40,88 @@ typedef std::list<circuit_node_t> list_of_circuit_t; ///< Type definition for li
 class BenchParser {
 private:
 
-    size_t id_counter;
+    /**
+     * A label can name up to three nodes: the gate driving it, an OUTPUT gate and
+     *  a FLIP FLOP. Bench and circuit nodes are stored in vectors indexed by the
+     *  node key 3 * label + role.
+     */
+    enum node_role_t : size_t {
+        GATE_NODE = 0,
+        OUTPUT_NODE = 1,
+        FLIP_FLOP_NODE = 2,
+        NUMBER_OF_ROLES = 3
+    };
+
+    std::shared_ptr<LabelTable> label_table; ///< Interned labels of all nodes read from the bench file
 
-    std::set<label_t> output_labels;     ///< Set containing bench node labels of all OUTPUT gates
-    std::set<label_t> ff_labels;   ///< Set containing bench node labels of all FLIP FLOP gates.
+    std::vector<label_id_t> output_labels;     ///< Bench node labels of all OUTPUT gates
+    std::vector<label_id_t> ff_labels;   ///< Bench node labels of all FLIP FLOP gates.
     ///<  When a FLIP FLOP gate is parsed, it is split into two circuit's gates:
     ///< one will be handled as INPUT gate and the other one as OUTPUT gate.
 
     std::set<label_t> outputs;
 
-    std::set<size_t> output_circuits;        ///< Set containing the unique ID of all OUTPUT gates
-    std::set<size_t> input_circuits;        ///< Set containing the unique ID of all INPUT gates
+    std::vector<std::pair<label_t, label_t>> flip_flops; ///< (state label, next state label) of every FLIP FLOP
+    std::set<label_t> primary_inputs;      ///< Labels of all INPUT gates that are not FLIP FLOP outputs
+
+    std::vector<bench_node_t> label_to_node;                   ///< Mapping from node keys to bench nodes
+    std::vector<unique_ID_t> labels_to_id;                   ///< Mapping from node keys to circuit unique IDs
 
-    std::unordered_map<label_t, bench_node_t> label_to_node;                   ///< Mapping from bench node labels to bench node
-    std::unordered_map<label_t, size_t> labels_to_id;                   ///< Mapping from bench node labels to circuit unique IDs
-    std::unordered_map<size_t, circuit_node_t> id_to_circuit_node;  ///< Mapping from circuit unique IDs to circuit nodes
+    /* Circuit before sorting, IDs are handed out in depth first pre-order */
+    std::vector<size_t> preorder_keys;        ///< Node key of every node, indexed by its pre-order ID
+    std::vector<bool> preorder_on_stack;      ///< Whether a node's inputs are still being added, to detect cycles
+    std::vector<unique_ID_t> preorder_roots;  ///< Pre-order IDs of all OUTPUT and FLIP FLOP gates
 
     /* Topological Sorted Circuit */
-    list_of_circuit_t sorted_circuit; ///< List contained the topological sorted circuit nodes
+    Circuit circuit; ///< Flat circuit, nodes are stored in topological order
+
+
+    /**
+     * \brief return the role a gate type is stored under.
+     * \param gate_type is gate_type_t
+     * \return node_role_t
+     */
+    static node_role_t NodeRole(gate_type_t gate_type);
 
+    /**
+     * \brief return the key of the node with the given label and role.
+     * \param label is label_id_t
+     * \param role is node_role_t
+     * \return size_t index into label_to_node and labels_to_id
+     */
+    static size_t NodeKey(label_id_t label, node_role_t role);
 
+    /**
+     * \brief sorts labels by name and removes duplicates.
+     * \param labels is std::vector<label_id_t>
+     * \return none
+     *
+     *  Keeps the order in which outputs are built independent of the interned IDs.
+     */
+    void SortLabels(std::vector<label_id_t> &labels);
+
+    /**
+     * \brief return the number of inputs of a bench node, an OUTPUT gate has the gate with its label as input.
+     * \param bench_node is bench_node_t
+     * \return size_t
+     */
+    static size_t InputCount(const bench_node_t &bench_node);
+
+    /**
+     * \brief return the node key of an input of a bench node.
+     * \param bench_node is bench_node_t
+     * \param input is the index of the input
+     * \return size_t
+     */
+    static size_t InputKey(const bench_node_t &bench_node, size_t input);
+
+    /**
+     * \brief return the circuit ID of an input of a bench node, which must be part of the circuit.
+     * \param bench_node is bench_node_t
+     * \param input is the index of the input
+     * \return unique_ID_t
+     */
+    unique_ID_t InputId(const bench_node_t &bench_node, size_t input);
 
     /**
      * \brief Print the labels2node_table table.
@@ -157,42 +196,6 @@ private:
      */
     void PrintSortedCircuitList();
 
-    /* ----------------
-     * Get functions
-     * ----------------
-     */
-
-    /**
-     * \brief return a list with the UUID of the INPUT gates of the circuit.
-     * \param none
-     * \return set_of_circuit_t
-     *
-     */
-    set_of_circuit_t GetListOfCircuitsInputs();
-
-    /**
-     * \brief return a list with the UUID of the OUTPUT gates of the circuit.
-     * \param none
-     * \return set_of_circuit_t
-     *
-     */
-    set_of_circuit_t GetListOfCircuitsOutputs();
-
-    /**
-     * \brief return a circuit node, given a its unique ID.
-     * \param circuit_node_uuid is unique_ID_t
-     * \return circuit_node_type
-     *
-     */
-    circuit_node_t GetCircuitNode(unique_ID_t circuit_node_uuid);
-
-    /**
-     * \brief return the table representing the circuit.
-     * \param none
-     * \return unordered_map<unique_ID_t, circuit_node_type>
-     *
-     */
-    std::unordered_map<unique_ID_t, circuit_node_t> GetCircuit();
     /* ---------------
      * Read File Functions
      * ---------------
@@ -224,44 +227,21 @@ private:
      */
     bool addToLabelTable(bench_node_t bench_node);
 
-    /**
-     * \brief search or add the node to the circuit.
-     * \param bench_node is bench_node_t
-     * \return unique_ID_t representing the given bench_node
-     *
-     *  It searches if the bench node exist in the label2uuid_table.
-     *  If it does't, adds it to the table and return the unique ID.
-     *  Otherwise, simply return the unique ID of the node.
-     *
-     */
-    unique_ID_t findOrAddToCircuit(const bench_node_t& bench_node);
-
     /**
      * \brief find or add a node to the circuit given its label.
-     * \param node_label is label_t
+     * \param node_label is label_id_t
+     * \param role is node_role_t and selects the gate driving the label, the OUTPUT or the FLIP FLOP
      * \return unique_ID_t representing the given label
      *
      *  It searches if the node corresponding to the given label is
      *      already inserted into the labels2uuid_table table. If it is,
-     *      returns its id. If not, creates a new node into the circuit
-     *      and add it to the table.
+     *      returns its id. If not, adds the node and all of its missing
+     *      inputs to the circuit with an iterative depth first search
+     *      and returns the pre-order ID of the node.
      *
+     * \throws std::runtime_error if a label is not driven by any gate or the circuit has a cycle
      */
-    unique_ID_t findOrAddToCircuitByLabel(const label_t& node_label);
-
-    /* --------------------
-     * Conversion functions
-     * --------------------
-     */
-
-    /**
-     * \brief converts bench node to circuit node.
-     * \param bench_node is bench_node_t and represents the node to be converted.
-     * \return circuit_node_type
-     *
-     *  Given a bench_node_t, it converts the node into an circuit_node_type.
-     */
-    circuit_node_t benchNodeToCircuitNode(const bench_node_t& bench_node);
+    unique_ID_t findOrAddToCircuitByLabel(label_id_t node_label, node_role_t role);
 
     /*
      *
@@ -279,11 +259,12 @@ private:
 
     /**
      * \brief create a circuit from the given node's label.
-     * \param bnode_label is label_t
+     * \param bnode_label is label_id_t
+     * \param role is node_role_t
      * \return none
      *
      */
-    void createCircuitByLabel(const label_t& bnode_label);
+    void createCircuitByLabel(label_id_t bnode_label, node_role_t role);
 
     /* -----------------------------
      * Topological Sort Algorithms
@@ -293,28 +274,16 @@ private:
     /**
      * \brief Implementation of Kahn's Algorithm for topological sort.
      * \param none
-     * \return none (the result is stored at sorted_circuit variable)
+     * \return none (the result is stored at the circuit variable)
      *
+     *  Starting from the OUTPUT and FLIP FLOP gates, a node is taken once all of its outputs
+     *      are taken, the one with the smallest pre-order ID first. The variable order of the
+     *      BDDs follows from this order. Outputs are counted down in a flat array, so apart
+     *      from the heap of ready nodes every node and edge is touched a constant number of
+     *      times. The sorted nodes are renumbered and stored in the circuit.
      */
     void TopologicalSortKahnsAlgorithm();
 
-    /* -----------------------------
-     * Auxiliar functions for
-     * Topological Sort Algorithms
-     * -----------------------------
-     */
-
-    /**
-     * \brief auxiliar function for topological sort algorithms.
-     * \param src_node is unique_ID_t
-     * \param dst_node is unique_ID_t
-     * \return True if it was the only outgoing edge. False, otherwise.
-     *
-     * It removes the edge from src->dst at the table uuid2circuitNode and
-     * then checks if it was the only outgoing edge.
-     */
-    bool IsUniqueOutgoingEdge(unique_ID_t src_node, unique_ID_t dst_node);
-
 public:
     /**
     * \brief Constructor
@@ -330,19 +299,37 @@ public:
 
 
     /**
-     * \brief return the list of circuit nodes topologically sorted.
+     * \brief return the circuit, its nodes are topologically sorted.
      * \param none
-     * \return list_of_circuit_t
+     * \return const Circuit&
      *
      */
-    list_of_circuit_t GetSortedCircuit();
+    const Circuit &GetSortedCircuit();
 
     /**
      * \brief return a list with the labels of the OUTPUT gates of the circuit. The label's list also includes the FLIP_FLOPS
      * \param none
-     * \return std::set<label_t>
+     * \return const std::set<label_t>&
+     *
+     */
+    const std::set<label_t> &GetListOfOutputLabels();
+
+    /**
+     * \brief return the FLIP FLOPS of the circuit as pairs of state label and next state label.
+     * \param none
+     * \return const std::vector<std::pair<label_t, label_t>>&
+     *
+     *  The state label is the label of the FLIP FLOP's INPUT gate, the next state label is the
+     *      label of the gate driving the FLIP FLOP.
+     */
+    const std::vector<std::pair<label_t, label_t>> &GetListOfFlipFlops();
+
+    /**
+     * \brief return the labels of the primary INPUT gates, FLIP FLOP outputs are not included.
+     * \param none
+     * \return const std::set<label_t>&
      *
      */
-    std::set<label_t> GetListOfOutputLabels();
+    const std::set<label_t> &GetListOfPrimaryInputLabels();
 
 };
@@ -0,0 +1,56 @@
+//
+// Sequential reachability for ISCAS89 bench files
+//
+
+#include "BenchReachability.hpp"
+
+
+BenchReachability::BenchReachability(BenchParser &parsed_circuit, const std::string &benchmark_file,
+                                     unsigned int image_threads) {
+
+    auto flip_flops = parsed_circuit.GetListOfFlipFlops();
+    auto primary_inputs = parsed_circuit.GetListOfPrimaryInputLabels();
+
+    if (flip_flops.empty()) {
+        throw std::runtime_error("BenchReachability: the circuit has no flip flops!");
+    }
+
+    fsm = make_shared<ClassProject::Reachability>(flip_flops.size(), primary_inputs.size());
+    fsm->setImageThreads(image_threads);
+
+    /* FLIP FLOP outputs and primary inputs are mapped onto the state machine's variables */
+    std::unordered_map<label_t, ClassProject::BDD_ID> bindings;
+    for (size_t i = 0; i < flip_flops.size(); i++) {
+        state_labels.push_back(flip_flops[i].first);
+        bindings[flip_flops[i].first] = fsm->getStates().at(i);
+    }
+    size_t input_index = 0;
+    for (const auto &input_label : primary_inputs) {
+        bindings[input_label] = fsm->getInputs().at(input_index++);
+    }
+
+    /* Build the next state functions in the manager of the state machine */
+    CircuitToBDD circuit2BDD(fsm);
+    circuit2BDD.SetInputVariables(bindings);
+    circuit2BDD.GenerateBDD(parsed_circuit.GetSortedCircuit(), benchmark_file);
+
+    std::vector<ClassProject::BDD_ID> transition_functions;
+    for (const auto &flip_flop : flip_flops) {
+        transition_functions.push_back(circuit2BDD.GetBddId(flip_flop.second));
+    }
+    fsm->setTransitionFunctions(transition_functions);
+    fsm->setInitState(std::vector<bool>(flip_flops.size(), false));
+}
+
+ClassProject::InvariantResult BenchReachability::ComputeReachableStates() {
+    /* The invariant True never fails, so the traversal runs up to the fixed point */
+    return fsm->checkInvariant(fsm->True());
+}
+
+shared_ptr<ClassProject::Reachability> BenchReachability::GetStateMachine() {
+    return fsm;
+}
+
+const std::vector<label_t> &BenchReachability::GetStateLabels() {
+    return state_labels;
+}
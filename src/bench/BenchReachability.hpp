@@ -0,0 +1,62 @@
+//
+// Sequential reachability for ISCAS89 bench files
+//
+
+#pragma once
+
+#include "BenchParser.hpp"
+#include "CircuitToBDD.hpp"
+#include "../reachability/Reachability.h"
+
+
+/**
+ * \class BenchReachability
+ *
+ * \brief Class to build a state machine from a sequential (ISCAS89) circuit
+ *
+ *  Every FLIP FLOP becomes a state bit and every primary INPUT an input bit of a
+ *   ClassProject::Reachability state machine. The next state functions are generated
+ *   by CircuitToBDD directly in the manager of the state machine. The initial state
+ *   is the reset state, all FLIP FLOPS set to false.
+ *
+ */
+class BenchReachability {
+
+public:
+
+    /**
+     * \brief Builds the state machine of a parsed circuit
+     * \param parsed_circuit is the parsed bench file
+     * \param benchmark_file is the path to the bench file, used for the results directory
+     * \param image_threads is the number of threads for the image computation
+     *
+     * \throws std::runtime_error if the circuit has no FLIP FLOPS
+     */
+    BenchReachability(BenchParser &parsed_circuit, const std::string &benchmark_file, unsigned int image_threads = 1);
+
+    /**
+     * \brief Runs the forward fixpoint from the reset state
+     * \param none
+     * \return ClassProject::InvariantResult holding the reachable states and the sequential depth
+     */
+    ClassProject::InvariantResult ComputeReachableStates();
+
+    /**
+     * \brief Returns the state machine
+     * \param none
+     * \return shared_ptr<ClassProject::Reachability>
+     */
+    shared_ptr<ClassProject::Reachability> GetStateMachine();
+
+    /**
+     * \brief Returns the FLIP FLOP labels in the order of the state bits
+     * \param none
+     * \return const std::vector<label_t>&
+     */
+    const std::vector<label_t> &GetStateLabels();
+
+private:
+
+    shared_ptr<ClassProject::Reachability> fsm;
+    std::vector<label_t> state_labels; ///< state_labels[i] is the FLIP FLOP of state bit i
+};
@@ -0,0 +1,415 @@
+//
+// Running the benchmark over a directory of bench files with machine readable results
+//
+
+#include "BenchSuite.hpp"
+#include "BenchParser.hpp"
+#include "BenchmarkLib.h"
+#include "CircuitToBDD.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <csignal>
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <sstream>
+#include <stdexcept>
+#include <type_traits>
+#include <fcntl.h>
+#include <sys/wait.h>
+
+
+/* Parses, builds and dumps a circuit, runs in the child process */
+static suite_run_t MeasureCircuit(const std::string &file, const suite_options_t &options) {
+    suite_run_t run;
+    if (options.counters) {
+        open_hw_counters();
+    }
+
+    double start = wallTime();
+    hw_counters_t counters = read_hw_counters();
+    BenchParser parsed_circuit(file);
+    const Circuit &circuit = parsed_circuit.GetSortedCircuit();
+    run.parse_counters = hw_counters_delta(counters, read_hw_counters());
+    run.parse_time = wallTime() - start;
+
+    auto manager = make_shared<ClassProject::Manager>();
+    CircuitToBDD circuit2BDD(manager);
+    if (options.gc) {
+        circuit2BDD.EnableGarbageCollection(1 << 20);
+    }
+    start = wallTime();
+    counters = read_hw_counters();
+    if (options.threads > 1) {
+        circuit2BDD.GenerateBDDParallel(circuit, file, options.threads);
+    } else {
+        circuit2BDD.GenerateBDD(circuit, file);
+    }
+    run.build_counters = hw_counters_delta(counters, read_hw_counters());
+    run.build_time = wallTime() - start;
+    run.unique_table_size = manager->uniqueTableSize();
+    run.computed_table_size = manager->computedTableSize();
+
+    start = wallTime();
+    counters = read_hw_counters();
+    circuit2BDD.PrintBDD(parsed_circuit.GetListOfOutputLabels(), options.threads, false, options.formats);
+    run.dump_counters = hw_counters_delta(counters, read_hw_counters());
+    run.dump_time = wallTime() - start;
+    run.output_nodes = circuit2BDD.GetPrintedNodes();
+    return run;
+}
+
+template<typename T>
+static T MedianOf(std::vector<T> values) {
+    std::nth_element(values.begin(), values.begin() + values.size() / 2, values.end());
+    return values[values.size() / 2];
+}
+
+/* Column and key names of the hardware counters, by hw_counter_t */
+static const char *COUNTER_NAMES[HW_COUNTERS] = {"cycles", "instructions", "llc_misses", "dtlb_misses", "branch_misses"};
+static const char *PHASE_NAMES[] = {"parse", "build", "dump"};
+static constexpr hw_counters_t suite_run_t::*PHASE_COUNTERS[] = {&suite_run_t::parse_counters,
+                                                                 &suite_run_t::build_counters,
+                                                                 &suite_run_t::dump_counters};
+
+static double TotalTime(const suite_run_t &run) {
+    return run.parse_time + run.build_time + run.dump_time;
+}
+
+static double MedianTotalTime(const std::vector<suite_run_t> &runs) {
+    std::vector<double> totals;
+    for (const auto &run : runs) {
+        totals.push_back(TotalTime(run));
+    }
+    return MedianOf(totals);
+}
+
+static std::string JsonString(const std::string &text) {
+    std::string quoted = "\"";
+    for (const char c : text) {
+        if (c == '"' || c == '\\') quoted += '\\';
+        quoted += c;
+    }
+    return quoted + "\"";
+}
+
+/* total_time is passed in, the median of the totals is not the sum of the phase medians */
+static void WriteRunJson(std::ostream &out, const suite_run_t &run, double total_time) {
+    out << "{\"parse_time\": " << run.parse_time << ", \"build_time\": " << run.build_time
+        << ", \"dump_time\": " << run.dump_time << ", \"total_time\": " << total_time
+        << ", \"output_nodes\": " << run.output_nodes << ", \"unique_table_size\": " << run.unique_table_size
+        << ", \"computed_table_size\": " << run.computed_table_size << ", \"peak_rss_kb\": " << run.peak_rss;
+
+    /* Counters only appear where they were counted */
+    std::vector<std::string> phases;
+    for (size_t p = 0; p < 3; p++) {
+        const hw_counters_t &counters = run.*PHASE_COUNTERS[p];
+        std::string values;
+        for (int c = 0; c < HW_COUNTERS; c++) {
+            if (!counters.valid[c]) continue;
+            values += (values.empty() ? "\"" : ", \"") + std::string(COUNTER_NAMES[c]) + "\": " +
+                      std::to_string(counters.value[c]);
+        }
+        if (!values.empty()) {
+            phases.push_back("\"" + std::string(PHASE_NAMES[p]) + "\": {" + values + "}");
+        }
+    }
+    if (!phases.empty()) {
+        out << ", \"counters\": {";
+        for (size_t p = 0; p < phases.size(); p++) {
+            out << ((p == 0) ? "" : ", ") << phases[p];
+        }
+        out << "}";
+    }
+    out << "}";
+}
+
+BenchSuite::BenchSuite(const std::string &directory, const suite_options_t &options) : options(options) {
+    if (!std::filesystem::is_directory(directory)) {
+        throw std::runtime_error("BenchSuite: " + directory + " is not a directory!");
+    }
+    for (const auto &entry : std::filesystem::directory_iterator(directory)) {
+        if (entry.path().extension() == ".bench") {
+            files.push_back(entry.path().string());
+        }
+    }
+    if (files.empty()) {
+        throw std::runtime_error("BenchSuite: " + directory + " has no bench files!");
+    }
+    std::sort(files.begin(), files.end());
+}
+
+std::string BenchSuite::RunCircuit(const std::string &file, suite_run_t &run) const {
+    int fds[2];
+    if (pipe(fds) != 0) {
+        throw std::runtime_error("BenchSuite: unable to create a pipe!");
+    }
+
+    /* Buffered output would otherwise be printed by the child as well */
+    std::cout.flush();
+    pid_t pid = fork();
+    if (pid < 0) {
+        close(fds[0]);
+        close(fds[1]);
+        throw std::runtime_error("BenchSuite: unable to fork!");
+    }
+
+    if (pid == 0) {
+        close(fds[0]);
+        int null_fd = open("/dev/null", O_WRONLY);
+        if (null_fd >= 0) {
+            dup2(null_fd, STDOUT_FILENO);
+        }
+        if (options.timeout > 0) {
+            alarm(options.timeout);
+        }
+        int exit_code = 0;
+        try {
+            suite_run_t measured = MeasureCircuit(file, options);
+            const char *data = reinterpret_cast<const char *>(&measured);
+            size_t written = 0;
+            while (written < sizeof(measured)) {
+                ssize_t count = write(fds[1], data + written, sizeof(measured) - written);
+                if (count <= 0) break;
+                written += count;
+            }
+        } catch (const std::exception &e) {
+            std::cerr << file << ": " << e.what() << std::endl;
+            exit_code = 1;
+        }
+        _exit(exit_code);
+    }
+
+    close(fds[1]);
+    char *data = reinterpret_cast<char *>(&run);
+    size_t received = 0;
+    while (received < sizeof(run)) {
+        ssize_t count = read(fds[0], data + received, sizeof(run) - received);
+        if (count < 0 && errno == EINTR) continue;
+        if (count <= 0) break;
+        received += count;
+    }
+    close(fds[0]);
+
+    int status = 0;
+    struct rusage usage{};
+    while (wait4(pid, &status, 0, &usage) < 0 && errno == EINTR) {}
+
+    if (WIFSIGNALED(status) && WTERMSIG(status) == SIGALRM) {
+        return "timeout";
+    }
+    if (!WIFEXITED(status) || WEXITSTATUS(status) != 0 || received != sizeof(run)) {
+        return "failed";
+    }
+    run.peak_rss = usage.ru_maxrss;
+    return "ok";
+}
+
+const std::vector<suite_result_t> &BenchSuite::Run() {
+    results.clear();
+    std::cout << "**** Suite ****" << std::endl;
+    std::cout << " Circuits: " << files.size() << "; Warmup runs: " << options.warmup << "; Repetitions: "
+              << options.repetitions << std::endl;
+
+    for (const auto &file : files) {
+        suite_result_t result;
+        result.circuit = std::filesystem::path(file).stem().string();
+        result.status = "ok";
+        for (size_t r = 0; r < options.warmup + options.repetitions && result.status == "ok"; r++) {
+            suite_run_t run;
+            result.status = RunCircuit(file, run);
+            if (result.status == "ok" && r >= options.warmup) {
+                result.runs.push_back(run);
+            }
+        }
+        if (result.status != "ok") {
+            result.runs.clear();
+            std::cout << " " << result.circuit << ": " << result.status << std::endl;
+        } else if (!result.runs.empty()) {
+            suite_run_t median = Median(result.runs);
+            std::cout << " " << result.circuit << ": Parse time: " << median.parse_time << "; Build time: "
+                      << median.build_time << "; Dump time: " << median.dump_time << "; Output nodes: "
+                      << median.output_nodes << "; Unique table size: " << median.unique_table_size
+                      << "; Peak RSS: " << median.peak_rss << std::endl;
+        }
+        results.push_back(result);
+    }
+    std::cout << std::endl;
+    return results;
+}
+
+suite_run_t BenchSuite::Median(const std::vector<suite_run_t> &runs) {
+    auto median = [&runs](auto field) {
+        std::vector<std::decay_t<decltype(runs.front().*field)>> values;
+        for (const auto &run : runs) {
+            values.push_back(run.*field);
+        }
+        return MedianOf(values);
+    };
+
+    suite_run_t result;
+    result.parse_time = median(&suite_run_t::parse_time);
+    result.build_time = median(&suite_run_t::build_time);
+    result.dump_time = median(&suite_run_t::dump_time);
+    result.output_nodes = median(&suite_run_t::output_nodes);
+    result.unique_table_size = median(&suite_run_t::unique_table_size);
+    result.computed_table_size = median(&suite_run_t::computed_table_size);
+    result.peak_rss = median(&suite_run_t::peak_rss);
+
+    for (const auto phase : PHASE_COUNTERS) {
+        for (int c = 0; c < HW_COUNTERS; c++) {
+            std::vector<long long> values;
+            for (const auto &run : runs) {
+                if ((run.*phase).valid[c]) values.push_back((run.*phase).value[c]);
+            }
+            (result.*phase).valid[c] = values.size() == runs.size();
+            (result.*phase).value[c] = (result.*phase).valid[c] ? MedianOf(values) : 0;
+        }
+    }
+    return result;
+}
+
+void BenchSuite::WriteJson(const std::string &file) const {
+    std::ofstream out(file);
+    if (!out.is_open()) {
+        throw std::runtime_error("Unable to open " + file + "!");
+    }
+
+    out << "{" << std::endl;
+    out << "  \"warmup\": " << options.warmup << ", \"repetitions\": " << options.repetitions << ", \"threads\": "
+        << options.threads << ", \"gc\": " << (options.gc ? "true" : "false") << "," << std::endl;
+    out << "  \"circuits\": [";
+    for (size_t c = 0; c < results.size(); c++) {
+        const suite_result_t &result = results[c];
+        out << ((c == 0) ? "" : ",") << std::endl;
+        out << "    {\"circuit\": " << JsonString(result.circuit) << ", \"status\": " << JsonString(result.status);
+        if (!result.runs.empty()) {
+            out << "," << std::endl << "     \"median\": ";
+            WriteRunJson(out, Median(result.runs), MedianTotalTime(result.runs));
+        }
+        out << "," << std::endl << "     \"runs\": [";
+        for (size_t r = 0; r < result.runs.size(); r++) {
+            out << ((r == 0) ? "" : ",") << std::endl << "      ";
+            WriteRunJson(out, result.runs[r], TotalTime(result.runs[r]));
+        }
+        out << "]}";
+    }
+    out << std::endl << "  ]" << std::endl << "}" << std::endl;
+}
+
+void BenchSuite::WriteCsv(const std::string &file) const {
+    std::ofstream out(file);
+    if (!out.is_open()) {
+        throw std::runtime_error("Unable to open " + file + "!");
+    }
+
+    /* Circuits that did not finish get a single row without measurements, counters that were not
+     * counted are left empty */
+    out << "circuit,status,run,parse_time,build_time,dump_time,total_time,output_nodes,unique_table_size,"
+           "computed_table_size,peak_rss_kb";
+    for (const auto *phase : PHASE_NAMES) {
+        for (const auto *counter : COUNTER_NAMES) {
+            out << "," << phase << "_" << counter;
+        }
+    }
+    out << std::endl;
+    for (const auto &result : results) {
+        if (result.runs.empty()) {
+            out << result.circuit << "," << result.status << ",0,0,0,0,0,0,0,0,0"
+                << std::string(3 * HW_COUNTERS, ',') << std::endl;
+        }
+        for (size_t r = 0; r < result.runs.size(); r++) {
+            const suite_run_t &run = result.runs[r];
+            out << result.circuit << "," << result.status << "," << r + 1 << "," << run.parse_time << ","
+                << run.build_time << "," << run.dump_time << "," << TotalTime(run) << "," << run.output_nodes << ","
+                << run.unique_table_size << "," << run.computed_table_size << "," << run.peak_rss;
+            for (const auto phase : PHASE_COUNTERS) {
+                for (int c = 0; c < HW_COUNTERS; c++) {
+                    out << ",";
+                    if ((run.*phase).valid[c]) out << (run.*phase).value[c];
+                }
+            }
+            out << std::endl;
+        }
+    }
+}
+
+size_t BenchSuite::CompareBaseline(const std::string &file, double threshold) const {
+    std::ifstream in(file);
+    if (!in.is_open()) {
+        throw std::runtime_error("Unable to open baseline " + file + "!");
+    }
+
+    /* Columns are found by their header, so baselines may carry more of them */
+    std::string line;
+    std::getline(in, line);
+    std::map<std::string, size_t> columns;
+    {
+        std::stringstream header(line);
+        std::string name;
+        for (size_t c = 0; std::getline(header, name, ','); c++) {
+            columns[name] = c;
+        }
+    }
+    size_t needed = 0;
+    for (const auto *name : {"circuit", "status", "total_time", "peak_rss_kb"}) {
+        if (columns.count(name) == 0) {
+            throw std::runtime_error("Baseline " + file + " has no column " + name + "!");
+        }
+        needed = std::max(needed, columns[name] + 1);
+    }
+
+    struct baseline_t {
+        std::string status;
+        std::vector<double> times;
+        std::vector<long> peak_rss;
+    };
+    std::map<std::string, baseline_t> baseline;
+    while (std::getline(in, line)) {
+        std::vector<std::string> fields;
+        std::stringstream row(line);
+        std::string field;
+        while (std::getline(row, field, ',')) {
+            fields.push_back(field);
+        }
+        if (fields.size() < needed) continue;
+
+        baseline_t &base = baseline[fields[columns["circuit"]]];
+        base.status = fields[columns["status"]];
+        if (base.status == "ok") {
+            base.times.push_back(std::stod(fields[columns["total_time"]]));
+            base.peak_rss.push_back(std::stol(fields[columns["peak_rss_kb"]]));
+        }
+    }
+
+    std::cout << "**** Baseline ****" << std::endl;
+    size_t regressions = 0;
+    for (const auto &result : results) {
+        auto base = baseline.find(result.circuit);
+        if (base == baseline.end() || base->second.status != "ok" || base->second.times.empty()) {
+            continue;
+        }
+        if (result.status != "ok" || result.runs.empty()) {
+            std::cout << " " << result.circuit << ": " << result.status << " (ok in the baseline)" << std::endl;
+            regressions++;
+            continue;
+        }
+
+        double base_time = MedianOf(base->second.times);
+        long base_rss = MedianOf(base->second.peak_rss);
+        /* Same statistic as the baseline side: the median of the total times of the runs */
+        suite_run_t median = Median(result.runs);
+        double time = MedianTotalTime(result.runs);
+
+        bool slower = time > base_time * (1 + threshold) && time - base_time > MIN_REGRESSION_TIME;
+        bool larger = median.peak_rss > base_rss * (1 + threshold);
+        if (slower || larger) {
+            std::cout << " " << result.circuit << ": Total time: " << base_time << " -> " << time << "; Peak RSS: "
+                      << base_rss << " -> " << median.peak_rss << std::endl;
+            regressions++;
+        }
+    }
+    std::cout << " Regressions: " << regressions << " (threshold " << threshold * 100 << "%)" << std::endl << std::endl;
+    return regressions;
+}
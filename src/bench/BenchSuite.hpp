@@ -0,0 +1,139 @@
+//
+// Running the benchmark over a directory of bench files with machine readable results
+//
+
+#pragma once
+
+#include "BddWriter.hpp"
+#include "BenchmarkLib.h"
+
+#include <string>
+#include <vector>
+
+
+/**
+ * \struct suite_options_t
+ * \brief How BenchSuite runs every circuit.
+ */
+typedef struct suite_options_t {
+    size_t warmup = 1;                                ///< Runs per circuit before the measured ones, discarded
+    size_t repetitions = 3;                           ///< Measured runs per circuit
+    unsigned int threads = 1;                         ///< Threads building and printing the outputs
+    bool gc = false;                                  ///< Garbage collect released gate BDDs while building
+    unsigned int formats = TEXT_FORMAT | DOT_FORMAT;  ///< Mask of bdd_format_t to dump
+    unsigned int timeout = 0;                         ///< Seconds a single run may take, 0 for no limit
+    bool counters = false;                            ///< Count hardware events of every phase, see open_hw_counters
+} suite_options_t;
+
+/**
+ * \struct suite_run_t
+ * \brief Measurements of one run of one circuit. Times are wall times in seconds.
+ */
+typedef struct suite_run_t {
+    double parse_time = 0;           ///< Parsing and sorting the bench file
+    double build_time = 0;           ///< Building the BDDs of all gates
+    double dump_time = 0;            ///< Writing the BDDs of all outputs
+    size_t output_nodes = 0;         ///< Distinct nodes of all output BDDs
+    size_t unique_table_size = 0;    ///< Nodes in the manager after the build
+    size_t computed_table_size = 0;  ///< Cached ite results after the build
+    long peak_rss = 0;               ///< Peak resident set size of the run in KB
+    hw_counters_t parse_counters{};  ///< Hardware events while parsing, all invalid without suite_options_t::counters
+    hw_counters_t build_counters{};  ///< Hardware events while building
+    hw_counters_t dump_counters{};   ///< Hardware events while dumping
+} suite_run_t;
+
+/**
+ * \struct suite_result_t
+ * \brief All measured runs of one circuit.
+ */
+typedef struct suite_result_t {
+    std::string circuit;            ///< Name of the bench file without extension
+    std::string status;             ///< "ok", "timeout" or "failed"
+    std::vector<suite_run_t> runs;  ///< Measured runs, empty unless status is "ok"
+} suite_result_t;
+
+/**
+ * \class BenchSuite
+ *
+ * \brief Class to benchmark every bench file of a directory
+ *
+ *  Every run parses, builds and dumps one circuit in a child process of its own, so the peak
+ *   RSS of a run is not hidden by an earlier, larger circuit and a run over the timeout can be
+ *   stopped. The dumps go to the usual results directories.
+ *
+ *  Results are written as JSON with the runs and medians of every circuit, or as CSV with one
+ *   row per run. A CSV of an earlier suite serves as baseline: a circuit regresses if its median
+ *   total time or peak RSS grows by more than the threshold, or if it no longer finishes.
+ *
+ */
+class BenchSuite {
+
+public:
+
+    /**
+     * \brief Finds the bench files of a directory
+     * \param directory contains the .bench files to run, in the order of their names
+     * \param options is suite_options_t
+     *
+     * \throws std::runtime_error if the directory has no bench file
+     */
+    BenchSuite(const std::string &directory, const suite_options_t &options);
+
+    /**
+     * \brief Runs all circuits and prints a line per circuit
+     * \param none
+     * \return the results of all circuits
+     */
+    const std::vector<suite_result_t> &Run();
+
+    /**
+     * \brief Writes the results as JSON
+     * \param file is the path of the JSON file
+     * \return none
+     *
+     * \throws std::runtime_error if the file cannot be written
+     */
+    void WriteJson(const std::string &file) const;
+
+    /**
+     * \brief Writes the results as CSV, one row per run
+     * \param file is the path of the CSV file
+     * \return none
+     *
+     * \throws std::runtime_error if the file cannot be written
+     */
+    void WriteCsv(const std::string &file) const;
+
+    /**
+     * \brief Compares the results with the CSV of an earlier suite and prints every regression
+     * \param file is the path of the baseline CSV written by WriteCsv
+     * \param threshold is the relative growth still accepted, 0.1 for 10%
+     * \return the number of regressed circuits
+     *
+     * \throws std::runtime_error if the baseline cannot be read
+     */
+    size_t CompareBaseline(const std::string &file, double threshold) const;
+
+    /**
+     * \brief Returns the median of every measurement over the given runs, counters only where valid in all runs
+     * \param runs is a non-empty list of runs
+     * \return suite_run_t
+     */
+    static suite_run_t Median(const std::vector<suite_run_t> &runs);
+
+    static constexpr double MIN_REGRESSION_TIME = 0.01; ///< Seconds a total time must grow by to count as regression
+
+private:
+
+    std::vector<std::string> files;
+    suite_options_t options;
+    std::vector<suite_result_t> results;
+
+    /**
+     * \brief Parses, builds and dumps one circuit in a child process
+     * \param file is the bench file
+     * \param run receives the measurements
+     * \return "ok", "timeout" or "failed"
+     */
+    std::string RunCircuit(const std::string &file, suite_run_t &run) const;
+};
@@ -8,6 +8,14 @@
 
 #include "BenchmarkLib.h"
 
+#include <cstdint>
+#include <cstring>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#endif
+
 using namespace std;
 
 
@@ -86,6 +94,12 @@ double userTime(void) {
     getrusage(RUSAGE_SELF, &ru);
     return (double)ru.ru_utime.tv_sec + (double)ru.ru_utime.tv_usec / 1000000; }
 
+double wallTime(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec / 1000000000.0;
+}
+
 int memReadStats(int field) {
     char    name[256];
     pid_t pid = getpid();
@@ -142,4 +156,89 @@ void process_mem_usage(double& vm_usage, double& resident_set)
 }
 
 
+static int hw_counter_fds[HW_COUNTERS] = {-1, -1, -1, -1, -1};
+
+static const char *hw_counter_names[HW_COUNTERS] = {"Cycles", "Instructions", "LLC misses", "dTLB misses",
+                                                    "Branch misses"};
+
+bool open_hw_counters(void) {
+	close_hw_counters();
+	bool any = false;
+#ifdef __linux__
+	const uint32_t types[HW_COUNTERS] = {PERF_TYPE_HARDWARE, PERF_TYPE_HARDWARE, PERF_TYPE_HW_CACHE,
+	                                     PERF_TYPE_HW_CACHE, PERF_TYPE_HARDWARE};
+	const uint64_t configs[HW_COUNTERS] = {
+		PERF_COUNT_HW_CPU_CYCLES,
+		PERF_COUNT_HW_INSTRUCTIONS,
+		PERF_COUNT_HW_CACHE_LL | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16),
+		PERF_COUNT_HW_CACHE_DTLB | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16),
+		PERF_COUNT_HW_BRANCH_MISSES};
+
+	for (int c = 0; c < HW_COUNTERS; c++) {
+		struct perf_event_attr attr;
+		memset(&attr, 0, sizeof(attr));
+		attr.size = sizeof(attr);
+		attr.type = types[c];
+		attr.config = configs[c];
+		attr.inherit = 1;        // threads started later are counted as well
+		attr.exclude_kernel = 1; // user space only, allowed with perf_event_paranoid 2
+		attr.exclude_hv = 1;
+		attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+		hw_counter_fds[c] = (int)syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0);
+		if (hw_counter_fds[c] >= 0)
+			any = true;
+	}
+#endif
+	return any;
+}
+
+void close_hw_counters(void) {
+	for (int c = 0; c < HW_COUNTERS; c++) {
+		if (hw_counter_fds[c] >= 0)
+			close(hw_counter_fds[c]);
+		hw_counter_fds[c] = -1;
+	}
+}
+
+hw_counters_t read_hw_counters(void) {
+	hw_counters_t counters;
+	for (int c = 0; c < HW_COUNTERS; c++) {
+		counters.value[c] = 0;
+		counters.valid[c] = false;
+
+		uint64_t data[3]; // value, time enabled, time running
+		if (hw_counter_fds[c] < 0 || read(hw_counter_fds[c], data, sizeof(data)) != (ssize_t)sizeof(data))
+			continue;
+		if (data[2] == 0)
+			continue;
+		counters.value[c] = (long long)((double)data[0] * data[1] / data[2]);
+		counters.valid[c] = true;
+	}
+	return counters;
+}
+
+hw_counters_t hw_counters_delta(const hw_counters_t &start, const hw_counters_t &end) {
+	hw_counters_t delta;
+	for (int c = 0; c < HW_COUNTERS; c++) {
+		delta.valid[c] = start.valid[c] && end.valid[c];
+		delta.value[c] = delta.valid[c] ? end.value[c] - start.value[c] : 0;
+	}
+	return delta;
+}
 
+void write_hw_counters(ostream &out, const hw_counters_t &counters) {
+	for (int c = 0; c < HW_COUNTERS; c++) {
+		out << (c == 0 ? "" : "; ") << hw_counter_names[c] << ": ";
+		if (counters.valid[c])
+			out << counters.value[c];
+		else
+			out << "n/a";
+		if (c == HW_INSTRUCTIONS) {
+			out << "; IPC: ";
+			if (counters.valid[HW_CYCLES] && counters.valid[HW_INSTRUCTIONS] && counters.value[HW_CYCLES] > 0)
+				out << (double)counters.value[HW_INSTRUCTIONS] / counters.value[HW_CYCLES];
+			else
+				out << "n/a";
+		}
+	}
+}
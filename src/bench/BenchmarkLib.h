@@ -13,6 +13,7 @@
  */
 
 #include <sys/time.h>
+#include <time.h>
 #include <sys/resource.h>
 #include <unistd.h>
 #include <string>
@@ -54,6 +55,9 @@ double totalTime(void);
 // returns user time - Taken from: Minisat-1.14 Global.h library
 double userTime(void);
 
+// returns the time of a monotonic clock, for wall time differences
+double wallTime(void);
+
 // Taken from: Minisat-1.14 Global.h library
 int memReadStats(int field);
 
@@ -61,4 +65,36 @@ long long memUsing();
 
 void process_mem_usage(double& vm_usage, double& resident_set);
 
+// hardware performance counters, counted with perf_event_open for this process and the threads it starts
+// after open_hw_counters
+enum hw_counter_t {
+	HW_CYCLES,
+	HW_INSTRUCTIONS,
+	HW_LLC_MISSES,
+	HW_DTLB_MISSES,
+	HW_BRANCH_MISSES,
+	HW_COUNTERS
+};
+
+// counter values, a counter is invalid if it could not be opened or never ran
+struct hw_counters_t {
+	long long value[HW_COUNTERS];
+	bool valid[HW_COUNTERS];
+};
+
+// opens the counters, returns false if none is available (no PMU, perf_event_paranoid, not Linux)
+bool open_hw_counters(void);
+
+// closes the counters
+void close_hw_counters(void);
+
+// returns the current counter values, scaled up if the kernel multiplexed the counters
+hw_counters_t read_hw_counters(void);
+
+// returns end - start, valid where both are
+hw_counters_t hw_counters_delta(const hw_counters_t &start, const hw_counters_t &end);
+
+// writes the counters in one line like "Cycles: 1200; Instructions: 800; IPC: 0.67; ...", n/a for invalid ones
+void write_hw_counters(ostream &out, const hw_counters_t &counters);
+
 #endif /* BENCHMARKLIB_H_ */
@@ -0,0 +1,113 @@
+//
+// Flat netlist in compressed sparse row form
+//
+
+#include "Circuit.hpp"
+
+#include <stdexcept>
+#include <utility>
+
+Circuit::Circuit(std::shared_ptr<const LabelTable> labels) : label_table(std::move(labels)) {
+    fanin_offsets.push_back(0);
+}
+
+unique_ID_t Circuit::AddNode(label_id_t label, gate_type_t gate_type, const std::vector<unique_ID_t> &fanins) {
+    unique_ID_t new_id = nodes.size();
+
+    for (const auto fanin : fanins) {
+        if (fanin >= new_id) {
+            throw std::runtime_error("Input node ID is not part of the circuit graph!");
+        }
+    }
+
+    nodes.push_back({new_id, label, gate_type});
+    fanin_ids.insert(fanin_ids.end(), fanins.begin(), fanins.end());
+    fanin_offsets.push_back(fanin_ids.size());
+    return new_id;
+}
+
+void Circuit::AddRoot(unique_ID_t id) {
+    roots.push_back(id);
+}
+
+void Circuit::Finalize() {
+    /* Count the outputs of every node, then turn the counts into offsets */
+    fanout_offsets.assign(nodes.size() + 1, 0);
+    for (const auto fanin : fanin_ids) {
+        fanout_offsets[fanin + 1]++;
+    }
+    for (size_t i = 0; i < nodes.size(); i++) {
+        fanout_offsets[i + 1] += fanout_offsets[i];
+    }
+
+    /* Nodes are visited in ascending order, so the outputs of every node end up sorted */
+    std::vector<size_t> next(fanout_offsets.begin(), fanout_offsets.end() - 1);
+    fanout_ids.resize(fanin_ids.size());
+    for (unique_ID_t id = 0; id < nodes.size(); id++) {
+        for (const auto fanin : GetFanins(id)) {
+            fanout_ids[next[fanin]++] = id;
+        }
+    }
+
+    /* Labels are looked up per selected or simulated output, so the gate of every label is indexed once */
+    label_gates.assign(label_table->Size(), NO_CIRCUIT);
+    for (const auto &node : nodes) {
+        if (node.label == NO_LABEL || node.gate_type == gate_type_t::OUTPUT ||
+            node.gate_type == gate_type_t::FLIP_FLOP) {
+            continue;
+        }
+        if (label_gates[node.label] == NO_CIRCUIT) label_gates[node.label] = node.id;
+    }
+}
+
+const std::vector<circuit_node_t> &Circuit::GetNodes() const {
+    return nodes;
+}
+
+size_t Circuit::Size() const {
+    return nodes.size();
+}
+
+id_range_t Circuit::GetFanins(unique_ID_t id) const {
+    return {fanin_ids.data() + fanin_offsets.at(id), fanin_ids.data() + fanin_offsets.at(id + 1)};
+}
+
+id_range_t Circuit::GetFanouts(unique_ID_t id) const {
+    return {fanout_ids.data() + fanout_offsets.at(id), fanout_ids.data() + fanout_offsets.at(id + 1)};
+}
+
+const std::vector<unique_ID_t> &Circuit::GetRoots() const {
+    return roots;
+}
+
+std::vector<bool> Circuit::GetFaninCone(const std::vector<unique_ID_t> &cone_roots) const {
+    std::vector<bool> in_cone(nodes.size(), false);
+    for (const auto root : cone_roots) {
+        in_cone.at(root) = true;
+    }
+    for (size_t id = nodes.size(); id-- > 0;) {
+        if (!in_cone[id]) continue;
+        for (const auto fanin : GetFanins(id)) {
+            in_cone[fanin] = true;
+        }
+    }
+    return in_cone;
+}
+
+unique_ID_t Circuit::FindGate(const label_t &label) const {
+    label_id_t label_id = label_table->Find(label);
+    if (label_id == NO_LABEL || label_id >= label_gates.size()) {
+        return NO_CIRCUIT;
+    }
+    return label_gates[label_id];
+}
+
+const label_t &Circuit::GetLabel(unique_ID_t id) const {
+    static const label_t no_label;
+    label_id_t label = nodes.at(id).label;
+    return (label == NO_LABEL) ? no_label : label_table->GetLabel(label);
+}
+
+std::shared_ptr<const LabelTable> Circuit::GetLabelTable() const {
+    return label_table;
+}
@@ -0,0 +1,170 @@
+//
+// Flat netlist in compressed sparse row form
+//
+
+#pragma once
+
+#include "BenchLexer.hpp"
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+/* Type definitions */
+typedef size_t unique_ID_t;             ///< Type definition for unique identifiers for circuits
+
+constexpr unique_ID_t NO_CIRCUIT = SIZE_MAX; ///< Marks a label without a circuit node
+
+/**
+ * \struct circuit_node_type
+ * \brief Struct that represents a node from a circuit.
+ *
+ *  The inputs and outputs of a node are kept by the Circuit, see Circuit::GetFanins and Circuit::GetFanouts.
+ */
+typedef struct circuit_node_t {
+    unique_ID_t id;                  ///< Unique ID for a node, equal to its position in the sorted circuit
+    label_id_t label;                ///< Interned node label, see Circuit::GetLabel
+    gate_type_t gate_type;           ///< Type of the gate (ex. AND, NOT, OR)
+} circuit_node_t;
+
+/**
+ * \struct id_range_t
+ * \brief Read-only view of consecutive circuit IDs, e.g. the inputs of a node.
+ */
+typedef struct id_range_t {
+    const unique_ID_t *first; ///< First ID of the range
+    const unique_ID_t *last;  ///< One past the last ID of the range
+
+    const unique_ID_t *begin() const { return first; }
+
+    const unique_ID_t *end() const { return last; }
+
+    size_t size() const { return static_cast<size_t>(last - first); }
+
+    bool empty() const { return first == last; }
+
+    unique_ID_t operator[](size_t i) const { return first[i]; }
+} id_range_t;
+
+/**
+ * \class Circuit
+ *
+ * \brief Topologically sorted netlist in compressed sparse row form.
+ *
+ *  Nodes are stored contiguously and ID i is the node at position i. The inputs of all
+ *   nodes are stored back to back in one array, node i owning the slice between
+ *   fanin_offsets[i] and fanin_offsets[i + 1]; outputs are stored the same way.
+ *   Nodes are added after all of their inputs, so every input has a smaller ID than
+ *   the node it drives and iterating the nodes in ID order is a topological order.
+ */
+class Circuit {
+private:
+    std::shared_ptr<const LabelTable> label_table; ///< Table the node labels are interned in
+
+    std::vector<circuit_node_t> nodes;      ///< All nodes, indexed by their ID
+    std::vector<size_t> fanin_offsets;      ///< Start of the inputs of each node in fanin_ids, plus the end
+    std::vector<unique_ID_t> fanin_ids;     ///< Inputs of all nodes, in the order passed to AddNode (ascending from BenchParser)
+    std::vector<size_t> fanout_offsets;     ///< Start of the outputs of each node in fanout_ids, plus the end
+    std::vector<unique_ID_t> fanout_ids;    ///< Outputs of all nodes, in ascending order per node
+    std::vector<unique_ID_t> roots;         ///< OUTPUT and FLIP FLOP nodes the circuit was built from
+    std::vector<unique_ID_t> label_gates;   ///< First gate driving each interned label, NO_CIRCUIT if none
+
+public:
+    /**
+     * \brief Constructor
+     * \param labels the table the labels of the nodes are interned in
+     */
+    explicit Circuit(std::shared_ptr<const LabelTable> labels);
+
+    /**
+     * \brief adds a node after all of its inputs.
+     * \param label is label_id_t
+     * \param gate_type is gate_type_t
+     * \param fanins are the IDs of the inputs, all of them already part of the circuit
+     * \return unique_ID_t the ID of the new node
+     *
+     * \throws std::runtime_error if an input is not part of the circuit yet
+     */
+    unique_ID_t AddNode(label_id_t label, gate_type_t gate_type, const std::vector<unique_ID_t> &fanins);
+
+    /**
+     * \brief marks a node as OUTPUT or FLIP FLOP the circuit is built for.
+     * \param id is unique_ID_t
+     * \return none
+     */
+    void AddRoot(unique_ID_t id);
+
+    /**
+     * \brief builds the output arrays, must be called once all nodes are added.
+     * \param none
+     * \return none
+     */
+    void Finalize();
+
+    /**
+     * \brief return all nodes in topological order.
+     * \param none
+     * \return const std::vector<circuit_node_t>&
+     */
+    const std::vector<circuit_node_t> &GetNodes() const;
+
+    /**
+     * \brief return the number of nodes.
+     * \param none
+     * \return size_t
+     */
+    size_t Size() const;
+
+    /**
+     * \brief return the inputs of a node.
+     * \param id is unique_ID_t
+     * \return id_range_t
+     */
+    id_range_t GetFanins(unique_ID_t id) const;
+
+    /**
+     * \brief return the outputs of a node, only valid after Finalize.
+     * \param id is unique_ID_t
+     * \return id_range_t
+     */
+    id_range_t GetFanouts(unique_ID_t id) const;
+
+    /**
+     * \brief return the OUTPUT and FLIP FLOP nodes the circuit was built from.
+     * \param none
+     * \return const std::vector<unique_ID_t>&
+     */
+    const std::vector<unique_ID_t> &GetRoots() const;
+
+    /**
+     * \brief return the transitive fan-in cone of the given nodes.
+     * \param cone_roots are the IDs of the nodes whose inputs are followed
+     * \return std::vector<bool> indexed by ID, true for every node in the cone, cone_roots included
+     *
+     *  Inputs have smaller IDs than the nodes they drive, so one sweep from the largest ID down suffices.
+     */
+    std::vector<bool> GetFaninCone(const std::vector<unique_ID_t> &cone_roots) const;
+
+    /**
+     * \brief return the ID of the gate driving a label, only valid after Finalize.
+     * \param label is label_t
+     * \return unique_ID_t, NO_CIRCUIT if no gate drives the label
+     *
+     *  OUTPUT and FLIP FLOP nodes are not considered. If several gates carry the label, the first one is returned.
+     */
+    unique_ID_t FindGate(const label_t &label) const;
+
+    /**
+     * \brief return the label of a node.
+     * \param id is unique_ID_t
+     * \return const label_t&, empty for nodes added without a label (NO_LABEL)
+     */
+    const label_t &GetLabel(unique_ID_t id) const;
+
+    /**
+     * \brief return the table the labels of the nodes are interned in.
+     * \param none
+     * \return std::shared_ptr<const LabelTable>
+     */
+    std::shared_ptr<const LabelTable> GetLabelTable() const;
+};
@@ -0,0 +1,214 @@
+//
+// Word-parallel random simulation of a sorted circuit
+//
+
+#include "CircuitSimulator.hpp"
+
+#include <set>
+#include <stdexcept>
+#include <unordered_map>
+
+/* splitmix64, a small generator whose whole state is one word */
+static uint64_t NextRandom(uint64_t &state) {
+    uint64_t z = (state += 0x9e3779b97f4a7c15ULL);
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    return z ^ (z >> 31);
+}
+
+/* FNV-1a, so the patterns of an input only depend on its label */
+static uint64_t HashLabel(const label_t &label) {
+    uint64_t hash = 0xcbf29ce484222325ULL;
+    for (const char c : label) {
+        hash = (hash ^ static_cast<unsigned char>(c)) * 0x100000001b3ULL;
+    }
+    return hash;
+}
+
+CircuitSimulator::CircuitSimulator(const Circuit &circuit, size_t words, uint64_t seed)
+        : circuit(circuit), words(words) {
+    if (words == 0) {
+        throw std::runtime_error("At least one word of patterns must be simulated!");
+    }
+
+    values.assign(circuit.Size() * words, 0);
+    input_nodes.assign(circuit.GetLabelTable()->Size(), NO_CIRCUIT);
+
+    for (const auto &node : circuit.GetNodes()) {
+        uint64_t *out = &values[node.id * words];
+        id_range_t fanins = circuit.GetFanins(node.id);
+
+        /* Folds all inputs into out with a bitwise operation, the loops over the words vectorize */
+        auto fold = [&](auto operation) {
+            const uint64_t *first = GetValues(fanins[0]);
+            for (size_t w = 0; w < words; w++) out[w] = first[w];
+            for (size_t i = 1; i < fanins.size(); i++) {
+                const uint64_t *in = GetValues(fanins[i]);
+                for (size_t w = 0; w < words; w++) out[w] = operation(out[w], in[w]);
+            }
+        };
+        auto invert = [&]() {
+            for (size_t w = 0; w < words; w++) out[w] = ~out[w];
+        };
+
+        switch (node.gate_type) {
+            case gate_type_t::INPUT: {
+                uint64_t state = seed ^ HashLabel(circuit.GetLabel(node.id));
+                for (size_t w = 0; w < words; w++) out[w] = NextRandom(state);
+                if (node.label != NO_LABEL) input_nodes[node.label] = node.id;
+                break;
+            }
+            case gate_type_t::CONST0:
+                break;
+            case gate_type_t::CONST1:
+                invert();
+                break;
+            case gate_type_t::OUTPUT:
+            case gate_type_t::FLIP_FLOP:
+            case gate_type_t::BUFFER:
+                fold([](uint64_t a, uint64_t) { return a; });
+                break;
+            case gate_type_t::NOT:
+                fold([](uint64_t a, uint64_t) { return a; });
+                invert();
+                break;
+            case gate_type_t::AND:
+                fold([](uint64_t a, uint64_t b) { return a & b; });
+                break;
+            case gate_type_t::NAND:
+                fold([](uint64_t a, uint64_t b) { return a & b; });
+                invert();
+                break;
+            case gate_type_t::OR:
+                fold([](uint64_t a, uint64_t b) { return a | b; });
+                break;
+            case gate_type_t::NOR:
+                fold([](uint64_t a, uint64_t b) { return a | b; });
+                invert();
+                break;
+            case gate_type_t::XOR:
+                fold([](uint64_t a, uint64_t b) { return a ^ b; });
+                break;
+        }
+    }
+}
+
+size_t CircuitSimulator::GetPatternCount() const {
+    return 64 * words;
+}
+
+const uint64_t *CircuitSimulator::GetValues(unique_ID_t id) const {
+    return &values.at(id * words);
+}
+
+std::vector<equivalence_class_t> CircuitSimulator::GetEquivalenceCandidates() const {
+    return GetEquivalenceCandidates({this});
+}
+
+std::vector<equivalence_class_t> CircuitSimulator::GetEquivalenceCandidates(
+        const std::vector<const CircuitSimulator *> &simulators) {
+    std::vector<equivalence_class_t> classes;
+    std::unordered_map<uint64_t, std::vector<size_t>> signatures; ///< Signature to the classes having it
+    size_t words = simulators.empty() ? 0 : simulators[0]->words;
+
+    for (size_t s = 0; s < simulators.size(); s++) {
+        const CircuitSimulator &simulator = *simulators[s];
+        if (simulator.words != words) {
+            throw std::runtime_error("Simulations with a different number of patterns cannot be compared!");
+        }
+        for (const auto &node : simulator.circuit.GetNodes()) {
+            if (node.gate_type == gate_type_t::OUTPUT || node.gate_type == gate_type_t::FLIP_FLOP) continue;
+
+            /* Values are normalized to a zero first pattern, so complementary nodes share a signature */
+            const uint64_t *node_values = simulator.GetValues(node.id);
+            uint64_t mask = (node_values[0] & 1) ? ~uint64_t(0) : 0;
+            uint64_t signature = 0;
+            for (size_t w = 0; w < words; w++) {
+                uint64_t state = signature ^ node_values[w] ^ mask;
+                signature = NextRandom(state);
+            }
+
+            auto &candidates = signatures[signature];
+            bool found = false;
+            for (const auto class_index : candidates) {
+                const equivalence_class_t &candidate = classes[class_index];
+                const uint64_t *representative = simulators[candidate.circuits[0]]->GetValues(candidate.nodes[0]);
+                uint64_t difference = mask ^ ((representative[0] & 1) ? ~uint64_t(0) : 0);
+                size_t w = 0;
+                while (w < words && (node_values[w] ^ representative[w]) == difference) w++;
+                if (w == words) {
+                    classes[class_index].circuits.push_back(s);
+                    classes[class_index].nodes.push_back(node.id);
+                    classes[class_index].complemented.push_back(difference != 0);
+                    found = true;
+                    break;
+                }
+            }
+            if (!found) {
+                candidates.push_back(classes.size());
+                classes.push_back({{s}, {node.id}, {false}});
+            }
+        }
+    }
+
+    std::vector<equivalence_class_t> candidate_classes;
+    for (auto &equivalence_class : classes) {
+        if (equivalence_class.nodes.size() > 1) candidate_classes.push_back(std::move(equivalence_class));
+    }
+    return candidate_classes;
+}
+
+std::vector<uint64_t> CircuitSimulator::EvaluateBdd(ClassProject::ManagerInterface &manager,
+                                                    ClassProject::BDD_ID root) const {
+    std::set<ClassProject::BDD_ID> bdd_nodes;
+    manager.findNodes(root, bdd_nodes);
+
+    std::vector<uint64_t> bdd_values(bdd_nodes.size() * words, 0);
+    std::unordered_map<ClassProject::BDD_ID, const uint64_t *> node_values;
+    std::unordered_map<ClassProject::BDD_ID, const uint64_t *> variable_values;
+
+    /* The set is ordered by ID, so both children of a node are evaluated before it */
+    uint64_t *out = bdd_values.data();
+    for (const auto bdd_node : bdd_nodes) {
+        node_values[bdd_node] = out;
+        if (manager.isConstant(bdd_node)) {
+            if (bdd_node == manager.True()) {
+                for (size_t w = 0; w < words; w++) out[w] = ~uint64_t(0);
+            }
+            out += words;
+            continue;
+        }
+
+        ClassProject::BDD_ID variable = manager.topVar(bdd_node);
+        auto got = variable_values.find(variable);
+        if (got == variable_values.end()) {
+            const label_t label = manager.getTopVarName(bdd_node);
+            label_id_t label_id = circuit.GetLabelTable()->Find(label);
+            if (label_id == NO_LABEL || input_nodes[label_id] == NO_CIRCUIT) {
+                throw std::runtime_error("There is no INPUT gate for the variable " + label + "!");
+            }
+            got = variable_values.emplace(variable, GetValues(input_nodes[label_id])).first;
+        }
+
+        const uint64_t *x = got->second;
+        const uint64_t *high = node_values.at(manager.coFactorTrue(bdd_node));
+        const uint64_t *low = node_values.at(manager.coFactorFalse(bdd_node));
+        for (size_t w = 0; w < words; w++) {
+            out[w] = (x[w] & high[w]) | (~x[w] & low[w]);
+        }
+        out += words;
+    }
+
+    const uint64_t *root_values = node_values.at(root);
+    return {root_values, root_values + words};
+}
+
+bool CircuitSimulator::MatchesBdd(ClassProject::ManagerInterface &manager, ClassProject::BDD_ID root,
+                                  unique_ID_t id) const {
+    std::vector<uint64_t> bdd_values = EvaluateBdd(manager, root);
+    const uint64_t *node_values = GetValues(id);
+    for (size_t w = 0; w < words; w++) {
+        if (bdd_values[w] != node_values[w]) return false;
+    }
+    return true;
+}
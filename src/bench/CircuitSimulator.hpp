@@ -0,0 +1,104 @@
+//
+// Word-parallel random simulation of a sorted circuit
+//
+
+#pragma once
+
+#include "Circuit.hpp"
+#include "../ManagerInterface.h"
+
+#include <cstdint>
+#include <vector>
+
+/**
+ * \struct equivalence_class_t
+ * \brief Nodes that had equal or complementary values on all simulated patterns.
+ */
+typedef struct equivalence_class_t {
+    std::vector<size_t> circuits;    ///< Simulator each member belongs to, see CircuitSimulator::GetEquivalenceCandidates
+    std::vector<unique_ID_t> nodes;  ///< Members of the class, the first one is the representative
+    std::vector<bool> complemented;  ///< True for members whose values are the complement of the representative's
+} equivalence_class_t;
+
+/**
+ * \class CircuitSimulator
+ *
+ * \brief Simulates a topologically sorted circuit on 64 random patterns per machine word.
+ *
+ *  Every node holds the same number of 64-bit words, bit b of word w being its value under
+ *   pattern 64 * w + b. The nodes are evaluated in ID order with one bitwise operation per
+ *   input and word. The patterns of an INPUT gate only depend on its label and the seed, so
+ *   two circuits simulated with the same seed see the same patterns on inputs of the same name.
+ */
+class CircuitSimulator {
+private:
+    const Circuit &circuit;            ///< The simulated circuit
+    size_t words;                      ///< Number of 64-bit words per node
+    std::vector<uint64_t> values;      ///< Values of all nodes, node i owning words [i * words, (i + 1) * words)
+    std::vector<unique_ID_t> input_nodes; ///< INPUT gate of each interned label, NO_CIRCUIT if there is none
+
+public:
+    /**
+     * \brief Constructor, simulates the circuit.
+     * \param circuit is the topologically sorted circuit, it must outlive the simulator
+     * \param words is the number of 64-bit words, i.e. 64 * words random patterns are simulated
+     * \param seed selects the random patterns
+     */
+    explicit CircuitSimulator(const Circuit &circuit, size_t words = 16, uint64_t seed = 1);
+
+    /**
+     * \brief return the number of simulated patterns.
+     * \param none
+     * \return size_t
+     */
+    size_t GetPatternCount() const;
+
+    /**
+     * \brief return the simulated values of a node, GetPatternCount() / 64 words.
+     * \param id is unique_ID_t
+     * \return const uint64_t*
+     */
+    const uint64_t *GetValues(unique_ID_t id) const;
+
+    /**
+     * \brief return the classes of gates with equal or complementary values on all patterns.
+     * \param none
+     * \return std::vector<equivalence_class_t>, only classes with at least two members
+     *
+     *  Equal simulation values only make nodes candidates, the equivalence must still be proved,
+     *   e.g. by comparing their BDDs. OUTPUT and FLIP FLOP nodes are not part of any class.
+     */
+    std::vector<equivalence_class_t> GetEquivalenceCandidates() const;
+
+    /**
+     * \brief return the classes of gates with equal or complementary values across several simulations.
+     * \param simulators are simulations with the same number of words, usually of different circuits with the same seed
+     * \return std::vector<equivalence_class_t>, members are ordered by simulator, then by ID
+     *
+     * \throws std::runtime_error if the simulators simulated a different number of patterns
+     */
+    static std::vector<equivalence_class_t> GetEquivalenceCandidates(
+            const std::vector<const CircuitSimulator *> &simulators);
+
+    /**
+     * \brief evaluates a BDD on the simulated patterns.
+     * \param manager is the manager holding the BDD
+     * \param root is the BDD to evaluate
+     * \return std::vector<uint64_t> with GetPatternCount() / 64 words
+     *
+     *  The nodes of the BDD are evaluated in ascending ID order, children always have smaller IDs.
+     *   Each variable takes the values of the INPUT gate with the same label.
+     *
+     * \throws std::runtime_error if a variable has no INPUT gate in the circuit
+     */
+    std::vector<uint64_t> EvaluateBdd(ClassProject::ManagerInterface &manager, ClassProject::BDD_ID root) const;
+
+    /**
+     * \brief checks a BDD against the simulated values of a node.
+     * \param manager is the manager holding the BDD
+     * \param root is the BDD of the node
+     * \param id is the node
+     * \return true if the BDD evaluates to the simulated values on all patterns
+     */
+    bool MatchesBdd(ClassProject::ManagerInterface &manager, ClassProject::BDD_ID root, unique_ID_t id) const;
+};
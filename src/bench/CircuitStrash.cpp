@@ -0,0 +1,257 @@
+//
+// Structural hashing and constant propagation on a sorted circuit
+//
+
+#include "CircuitStrash.hpp"
+
+#include <algorithm>
+#include <utility>
+
+/* Logic gates are the gates that compute a function of their inputs */
+static bool IsLogicGate(gate_type_t gate_type) {
+    return gate_type != gate_type_t::INPUT && gate_type != gate_type_t::OUTPUT &&
+           gate_type != gate_type_t::FLIP_FLOP;
+}
+
+CircuitStrash::CircuitStrash(const Circuit &source) : circuit(source.GetLabelTable()) {
+    std::vector<literal_t> literals(source.Size(), LIT_FALSE);
+    std::vector<unique_ID_t> labeled_nodes(source.Size(), NO_CIRCUIT);
+    std::vector<unique_ID_t> roots;
+
+    for (const auto &source_node : source.GetNodes()) {
+        id_range_t fanins = source.GetFanins(source_node.id);
+        std::vector<literal_t> inputs;
+        inputs.reserve(fanins.size());
+        for (const auto fanin : fanins) {
+            inputs.push_back(literals[fanin]);
+        }
+
+        literal_t literal = LIT_FALSE;
+        switch (source_node.gate_type) {
+            case gate_type_t::INPUT:
+                literal = 2 * AddNode(source_node.label, gate_type_t::INPUT, {});
+                break;
+            case gate_type_t::CONST0:
+                literal = LIT_FALSE;
+                break;
+            case gate_type_t::CONST1:
+                literal = LIT_TRUE;
+                break;
+            case gate_type_t::BUFFER:
+                literal = inputs[0];
+                break;
+            case gate_type_t::NOT:
+                literal = inputs[0] ^ 1;
+                break;
+            case gate_type_t::AND:
+                literal = ReduceGate(gate_type_t::AND, std::move(inputs), false, source_node.label);
+                break;
+            case gate_type_t::OR:
+                literal = ReduceGate(gate_type_t::OR, std::move(inputs), false, source_node.label);
+                break;
+            case gate_type_t::NAND:
+                literal = ReduceGate(gate_type_t::AND, std::move(inputs), true, source_node.label);
+                break;
+            case gate_type_t::NOR:
+                literal = ReduceGate(gate_type_t::OR, std::move(inputs), true, source_node.label);
+                break;
+            case gate_type_t::XOR:
+                literal = ReduceXor(inputs, source_node.label);
+                break;
+            case gate_type_t::OUTPUT:
+            case gate_type_t::FLIP_FLOP: {
+                /* The gate driving an OUTPUT or FLIP FLOP must keep its label */
+                unique_ID_t driver = fanins[0];
+                if (labeled_nodes[driver] == NO_CIRCUIT) {
+                    labeled_nodes[driver] = LabeledNode(literals[driver], source.GetNodes()[driver].label);
+                }
+                roots.push_back(AddNode(source_node.label, source_node.gate_type, {labeled_nodes[driver]}));
+                continue;
+            }
+        }
+        literals[source_node.id] = literal;
+
+        if (IsLogicGate(source_node.gate_type)) gates_before++;
+    }
+
+    /* Gates whose users were all folded away are dropped, INPUT gates are kept to keep the variables */
+    std::vector<bool> live(nodes.size(), false);
+    for (const auto root : roots) {
+        live[root] = true;
+    }
+    for (size_t id = nodes.size(); id-- > 0;) {
+        if (nodes[id].gate_type == gate_type_t::INPUT) live[id] = true;
+        if (!live[id]) continue;
+        for (const auto fanin : nodes[id].fanins) {
+            live[fanin] = true;
+        }
+    }
+
+    std::vector<unique_ID_t> new_ids(nodes.size(), NO_CIRCUIT);
+    for (unique_ID_t id = 0; id < nodes.size(); id++) {
+        if (!live[id]) continue;
+        for (auto &fanin : nodes[id].fanins) {
+            fanin = new_ids[fanin];
+        }
+        new_ids[id] = circuit.AddNode(nodes[id].label, nodes[id].gate_type, nodes[id].fanins);
+        if (IsLogicGate(nodes[id].gate_type)) gates_after++;
+    }
+    for (const auto root : roots) {
+        circuit.AddRoot(new_ids[root]);
+    }
+    circuit.Finalize();
+
+    /* Only the strashed circuit is needed from here on */
+    std::vector<strash_node_t>().swap(nodes);
+    std::vector<unique_ID_t>().swap(complement_nodes);
+    gate_table.clear();
+}
+
+unique_ID_t CircuitStrash::AddNode(label_id_t label, gate_type_t gate_type, std::vector<unique_ID_t> fanins) {
+    nodes.push_back({label, gate_type, std::move(fanins)});
+    complement_nodes.push_back(NO_CIRCUIT);
+    return nodes.size() - 1;
+}
+
+/* AND, OR and constants are complemented by their dual gate with the same inputs, everything else by a NOT */
+static std::pair<gate_type_t, bool> ComplementGate(gate_type_t gate_type) {
+    switch (gate_type) {
+        case gate_type_t::AND:    return {gate_type_t::NAND, true};
+        case gate_type_t::NAND:   return {gate_type_t::AND, true};
+        case gate_type_t::OR:     return {gate_type_t::NOR, true};
+        case gate_type_t::NOR:    return {gate_type_t::OR, true};
+        case gate_type_t::CONST0: return {gate_type_t::CONST1, true};
+        case gate_type_t::CONST1: return {gate_type_t::CONST0, true};
+        default:                  return {gate_type_t::NOT, false};
+    }
+}
+
+unique_ID_t CircuitStrash::NodeOf(literal_t literal, label_id_t label) {
+    if (literal == LIT_FALSE || literal == LIT_TRUE) {
+        if (constant_node == NO_CIRCUIT) {
+            constant_node = AddNode(NO_LABEL, gate_type_t::CONST0, {});
+        }
+        literal = 2 * constant_node + (literal == LIT_TRUE);
+    }
+
+    unique_ID_t node = literal >> 1;
+    if (!(literal & 1)) {
+        return node;
+    }
+    if (label == NO_LABEL && complement_nodes[node] != NO_CIRCUIT) {
+        return complement_nodes[node];
+    }
+
+    auto complement = ComplementGate(nodes[node].gate_type);
+    std::vector<unique_ID_t> fanins = complement.second ? nodes[node].fanins : std::vector<unique_ID_t>{node};
+    unique_ID_t complement_node = AddNode(label, complement.first, std::move(fanins));
+    if (label == NO_LABEL) {
+        complement_nodes[node] = complement_node;
+        complement_nodes[complement_node] = node;
+    }
+    return complement_node;
+}
+
+CircuitStrash::literal_t CircuitStrash::ReduceGate(gate_type_t gate_type, std::vector<literal_t> inputs,
+                                                   bool complement, label_id_t label) {
+    const literal_t controlling = (gate_type == gate_type_t::AND) ? LIT_FALSE : LIT_TRUE;
+    const literal_t identity = controlling ^ 1;
+
+    /* A controlling input decides the gate, identity inputs are dropped */
+    std::vector<literal_t> literals;
+    literals.reserve(inputs.size());
+    for (const auto input : inputs) {
+        if (input == controlling) return controlling ^ complement;
+        if (input != identity) literals.push_back(input);
+    }
+
+    /* A literal and its complement are adjacent after sorting, and also decide the gate */
+    std::sort(literals.begin(), literals.end());
+    literals.erase(std::unique(literals.begin(), literals.end()), literals.end());
+    for (size_t i = 1; i < literals.size(); i++) {
+        if ((literals[i - 1] ^ 1) == literals[i]) return controlling ^ complement;
+    }
+
+    if (literals.empty()) return identity ^ complement;
+    if (literals.size() == 1) return literals[0] ^ complement;
+
+    gate_key_t key{gate_type, {}};
+    key.fanins.reserve(literals.size());
+    for (const auto literal : literals) {
+        key.fanins.push_back(NodeOf(literal));
+    }
+    std::sort(key.fanins.begin(), key.fanins.end());
+    key.fanins.erase(std::unique(key.fanins.begin(), key.fanins.end()), key.fanins.end());
+    if (key.fanins.size() == 1) return (2 * key.fanins[0]) ^ complement;
+
+    auto got = gate_table.find(key);
+    if (got != gate_table.end()) {
+        return got->second ^ complement;
+    }
+
+    /* NAND and NOR gates are added as such, the table stores the complement of their node for the AND or OR */
+    gate_type_t node_type = complement ? ComplementGate(gate_type).first : gate_type;
+    literal_t literal = (2 * AddNode(label, node_type, key.fanins)) ^ complement;
+    gate_table.emplace(std::move(key), literal);
+    return literal ^ complement;
+}
+
+CircuitStrash::literal_t CircuitStrash::ReduceXor(const std::vector<literal_t> &inputs, label_id_t label) {
+    /* Constants and complemented inputs only flip the parity of the result */
+    bool parity = false;
+    std::vector<unique_ID_t> fanins;
+    fanins.reserve(inputs.size());
+    for (const auto input : inputs) {
+        if (input == LIT_FALSE || input == LIT_TRUE) {
+            parity ^= (input == LIT_TRUE);
+        } else {
+            parity ^= (input & 1);
+            fanins.push_back(input >> 1);
+        }
+    }
+
+    /* An input that appears twice cancels itself */
+    std::sort(fanins.begin(), fanins.end());
+    std::vector<unique_ID_t> odd_fanins;
+    for (size_t i = 0, j = 0; i < fanins.size(); i = j) {
+        while (j < fanins.size() && fanins[j] == fanins[i]) j++;
+        if ((j - i) & 1) odd_fanins.push_back(fanins[i]);
+    }
+
+    if (odd_fanins.empty()) return parity ? LIT_TRUE : LIT_FALSE;
+    if (odd_fanins.size() == 1) return (2 * odd_fanins[0]) ^ parity;
+
+    gate_key_t key{gate_type_t::XOR, std::move(odd_fanins)};
+    auto got = gate_table.find(key);
+    if (got != gate_table.end()) {
+        return got->second ^ parity;
+    }
+
+    /* A complemented XOR has no gate of its own, so it must not carry the label */
+    literal_t literal = 2 * AddNode(parity ? NO_LABEL : label, gate_type_t::XOR, key.fanins);
+    gate_table.emplace(std::move(key), literal);
+    return literal ^ parity;
+}
+
+unique_ID_t CircuitStrash::LabeledNode(literal_t literal, label_id_t label) {
+    if (literal == LIT_FALSE || literal == LIT_TRUE) {
+        return AddNode(label, (literal == LIT_TRUE) ? gate_type_t::CONST1 : gate_type_t::CONST0, {});
+    }
+
+    unique_ID_t node = literal >> 1;
+    if (literal & 1) {
+        return NodeOf(literal, label);
+    }
+    if (nodes[node].label == label) {
+        return node;
+    }
+    return AddNode(label, gate_type_t::BUFFER, {node});
+}
+
+const Circuit &CircuitStrash::GetCircuit() const {
+    return circuit;
+}
+
+size_t CircuitStrash::GetRemovedGates() const {
+    return (gates_before > gates_after) ? gates_before - gates_after : 0;
+}
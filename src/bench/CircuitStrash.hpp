@@ -0,0 +1,135 @@
+//
+// Structural hashing and constant propagation on a sorted circuit
+//
+
+#pragma once
+
+#include "Circuit.hpp"
+
+#include <unordered_map>
+#include <vector>
+
+/**
+ * \class CircuitStrash
+ *
+ * \brief Builds a structurally hashed copy of a topologically sorted circuit.
+ *
+ *  Every gate is reduced to a literal, a node of the new circuit plus a complement flag,
+ *   before it is added, so that
+ *   - BUFF gates and chains of NOT gates collapse into the literal they drive,
+ *   - constants are propagated, e.g. AND(a, NOT a) and XOR(a, a) fold to CONST0,
+ *   - repeated inputs are removed and gates with the same type and inputs are merged.
+ *
+ *  The INPUT gates keep their relative order, so the BDD variable order does not change.
+ *   The gates driving an OUTPUT or FLIP FLOP keep their label, if the label has no gate
+ *   of its own anymore a BUFF, NOT or CONST gate carrying it is added. Other labels of
+ *   merged gates are lost, and complement gates created by the pass are unlabeled.
+ */
+class CircuitStrash {
+private:
+    typedef size_t literal_t; ///< Node ID of the new circuit times two, plus one if complemented
+
+    static constexpr literal_t LIT_FALSE = SIZE_MAX - 1; ///< Constant zero, its complement is LIT_TRUE
+    static constexpr literal_t LIT_TRUE = SIZE_MAX;      ///< Constant one
+
+    /**
+     * \struct strash_node_t
+     * \brief Node of the new circuit before unused nodes are removed.
+     */
+    typedef struct strash_node_t {
+        label_id_t label;                ///< Label of the node, NO_LABEL for nodes created by the pass
+        gate_type_t gate_type;           ///< Type of the gate
+        std::vector<unique_ID_t> fanins; ///< Inputs of the gate, sorted ascending
+    } strash_node_t;
+
+    /**
+     * \struct gate_key_t
+     * \brief Key of the structural hash, AND, OR or XOR with its sorted input nodes.
+     */
+    typedef struct gate_key_t {
+        gate_type_t gate_type;
+        std::vector<unique_ID_t> fanins;
+
+        bool operator==(const gate_key_t &other) const {
+            return gate_type == other.gate_type && fanins == other.fanins;
+        }
+    } gate_key_t;
+
+    struct GateKeyHasher {
+        size_t operator()(const gate_key_t &k) const {
+            size_t hash = static_cast<size_t>(k.gate_type);
+            for (const auto fanin : k.fanins) {
+                hash = hash * 31 + fanin;
+            }
+            return hash;
+        }
+    };
+
+    std::vector<strash_node_t> nodes;                                      ///< Nodes of the new circuit
+    std::vector<unique_ID_t> complement_nodes;                             ///< Node computing the complement of a node, if any
+    std::unordered_map<gate_key_t, literal_t, GateKeyHasher> gate_table;   ///< Structural hash of all AND, OR and XOR gates
+    unique_ID_t constant_node = NO_CIRCUIT;                                ///< Unlabeled CONST0 node, if any
+
+    Circuit circuit;           ///< The strashed circuit
+    size_t gates_before = 0;   ///< Number of logic gates of the original circuit
+    size_t gates_after = 0;    ///< Number of logic gates of the strashed circuit
+
+    /**
+     * \brief adds a node to the new circuit.
+     * \return unique_ID_t the ID of the new node
+     */
+    unique_ID_t AddNode(label_id_t label, gate_type_t gate_type, std::vector<unique_ID_t> fanins);
+
+    /**
+     * \brief return a node computing a literal, adding a complement node if needed.
+     * \param literal is literal_t
+     * \param label is the label of the complement node if one is added, NO_LABEL to share it
+     * \return unique_ID_t
+     */
+    unique_ID_t NodeOf(literal_t literal, label_id_t label = NO_LABEL);
+
+    /**
+     * \brief reduces an AND, OR or XOR of literals, optionally complemented, to a literal.
+     * \param gate_type is AND, OR or XOR
+     * \param inputs are the literals of the gate inputs
+     * \param complement is true for NAND and NOR
+     * \param label is the label of the node if one is added
+     * \return literal_t
+     */
+    literal_t ReduceGate(gate_type_t gate_type, std::vector<literal_t> inputs, bool complement, label_id_t label);
+
+    /**
+     * \brief reduces an XOR of literals to a literal.
+     * \return literal_t
+     */
+    literal_t ReduceXor(const std::vector<literal_t> &inputs, label_id_t label);
+
+    /**
+     * \brief return a node computing a literal that carries the given label.
+     * \return unique_ID_t
+     */
+    unique_ID_t LabeledNode(literal_t literal, label_id_t label);
+
+public:
+    /**
+     * \brief Constructor, runs the pass.
+     * \param source is the topologically sorted circuit to strash
+     */
+    explicit CircuitStrash(const Circuit &source);
+
+    /**
+     * \brief return the strashed circuit.
+     * \param none
+     * \return const Circuit&
+     */
+    const Circuit &GetCircuit() const;
+
+    /**
+     * \brief return the number of logic gates the pass removed.
+     * \param none
+     * \return size_t, zero if complement gates outnumber the removed ones
+     *
+     *  Logic gates are all gates except INPUT, OUTPUT and FLIP FLOP.
+     */
+    size_t GetRemovedGates() const;
+};
@@ -5,18 +5,140 @@
 
 #include "CircuitToBDD.hpp"
 
+#include <algorithm>
+#include <exception>
+#include <iomanip>
+#include <queue>
+#include <thread>
 #include <utility>
 
 
 CircuitToBDD::CircuitToBDD(shared_ptr<ClassProject::ManagerInterface> BDD_manager_p) {
     bdd_manager = std::move(BDD_manager_p);
+    node_counter = dynamic_cast<ClassProject::Manager *>(bdd_manager.get());
 }
 
 CircuitToBDD::~CircuitToBDD() = default;
 
-void CircuitToBDD::GenerateBDD(const list_of_circuit_t &circuit, const std::string& benchmark_file) {
-    ClassProject::BDD_ID BDD_node;
+void CircuitToBDD::GenerateBDD(const Circuit &circuit, const std::string& benchmark_file) {
+    std::ofstream bdd_out_file = OpenResults(benchmark_file);
+    StartPipeline(circuit);
+    BuildGates(circuit, &bdd_out_file);
+    bdd_out_file.close();
+}
 
+void CircuitToBDD::BuildBDD(const Circuit &circuit) {
+    BuildGates(circuit, nullptr);
+}
+
+void CircuitToBDD::GenerateBDDParallel(const Circuit &circuit, const std::string &benchmark_file,
+                                       unsigned int threads) {
+    auto master = std::dynamic_pointer_cast<ClassProject::Manager>(bdd_manager);
+    if (master == nullptr) {
+        throw std::runtime_error("Parallel construction needs a ClassProject::Manager!");
+    }
+    std::ofstream bdd_out_file = OpenResults(benchmark_file);
+    StartPipeline(circuit);
+
+    std::vector<unique_ID_t> kept_gates = KeptGates(circuit);
+    std::sort(kept_gates.begin(), kept_gates.end());
+    kept_gates.erase(std::unique(kept_gates.begin(), kept_gates.end()), kept_gates.end());
+
+    /* Largest cones first, each to the worker with the least work so far */
+    std::vector<std::pair<size_t, unique_ID_t>> cones;
+    for (const auto gate : kept_gates) {
+        std::vector<bool> cone = circuit.GetFaninCone({gate});
+        cones.emplace_back(std::count(cone.begin(), cone.end(), true), gate);
+    }
+    std::sort(cones.rbegin(), cones.rend());
+
+    threads = std::max(1u, std::min<unsigned int>(threads, static_cast<unsigned int>(cones.size())));
+    std::vector<std::set<label_t>> worker_outputs(threads);
+    std::vector<std::vector<unique_ID_t>> worker_gates(threads);
+    std::vector<size_t> worker_load(threads, 0);
+    for (const auto &cone : cones) {
+        size_t worker = std::min_element(worker_load.begin(), worker_load.end()) - worker_load.begin();
+        worker_load[worker] += cone.first;
+        worker_outputs[worker].insert(circuit.GetLabel(cone.second));
+        worker_gates[worker].push_back(cone.second);
+    }
+
+    /* Every worker creates all variables first and in circuit order, so the variable IDs agree in all managers */
+    std::vector<shared_ptr<ClassProject::Manager>> managers(threads);
+    std::vector<std::unordered_map<label_t, ClassProject::BDD_ID>> worker_variables(threads);
+    std::vector<std::vector<ClassProject::BDD_ID>> worker_roots(threads);
+    std::vector<std::exception_ptr> errors(threads);
+    std::vector<std::thread> workers;
+    for (unsigned int w = 0; w < threads; w++) {
+        workers.emplace_back([&, w]() {
+            ClassProject::TraceSpan span("buildWorker", "build", w);
+            try {
+                managers[w] = make_shared<ClassProject::Manager>();
+                for (const auto &node : circuit.GetNodes()) {
+                    if (node.gate_type == gate_type_t::INPUT) {
+                        worker_variables[w][circuit.GetLabel(node.id)] = managers[w]->createVar(
+                                circuit.GetLabel(node.id));
+                    }
+                }
+
+                CircuitToBDD worker(managers[w]);
+                worker.SetInputVariables(worker_variables[w]);
+                worker.SetSelectedOutputs(worker_outputs[w]);
+                if (gc_manager != nullptr) {
+                    worker.EnableGarbageCollection(gc_min_nodes);
+                }
+                worker.BuildBDD(circuit);
+                for (const auto gate : worker_gates[w]) {
+                    worker_roots[w].push_back(worker.GetBddId(circuit.GetLabel(gate)));
+                }
+            } catch (...) {
+                errors[w] = std::current_exception();
+            }
+        });
+    }
+    for (auto &worker: workers) {
+        worker.join();
+    }
+    for (const auto &error : errors) {
+        if (error) std::rethrow_exception(error);
+    }
+
+    /* The master creates its variables in the same order, then imports the outputs of every worker */
+    label_table = circuit.GetLabelTable();
+    node_to_bdd_id.assign(circuit.Size(), NO_BDD);
+    label_to_bdd_id.assign(label_table->Size(), NO_BDD);
+
+    ClassProject::BDD_ID last_variable = master->True();
+    for (const auto &variable : worker_variables[0]) {
+        last_variable = std::max(last_variable, variable.second);
+    }
+    std::vector<ClassProject::BDD_ID> var_map(last_variable + 1, NO_BDD);
+    for (const auto &node : circuit.GetNodes()) {
+        if (node.gate_type == gate_type_t::INPUT) {
+            var_map[worker_variables[0].at(circuit.GetLabel(node.id))] = InputGate(node.label);
+        }
+    }
+
+    /* One batch per worker, so subgraphs shared by its outputs are copied once */
+    for (unsigned int w = 0; w < threads; w++) {
+        ClassProject::TraceSpan span("import", "build", w);
+        std::vector<ClassProject::BDD_ID> roots = master->importFrom(*managers[w], worker_roots[w], var_map);
+        for (size_t i = 0; i < worker_gates[w].size(); i++) {
+            unique_ID_t gate = worker_gates[w][i];
+            node_to_bdd_id[gate] = roots[i];
+            label_to_bdd_id[circuit.GetNodes()[gate].label] = roots[i];
+            PipelineOutput(circuit, gate, roots[i]);
+        }
+        managers[w].reset();
+    }
+
+    for (const auto gate : kept_gates) {
+        bdd_out_file << node_to_bdd_id[gate] << "," << circuit.GetLabel(gate) << "\n";
+    }
+    bdd_out_file.close();
+}
+
+std::ofstream CircuitToBDD::OpenResults(const std::string &benchmark_file) {
     std::filesystem::path pathToBenchFile(benchmark_file);
     if (!pathToBenchFile.has_filename())
         throw std::runtime_error("circuit_to_BDD_manager::GenerateBDD: benchmark_file not specified");
@@ -35,262 +157,446 @@ void CircuitToBDD::GenerateBDD(const list_of_circuit_t &circuit, const std::stri
     }
 
     bdd_out_file << "BDD_ID,Bench Label" << std::endl;
+    return bdd_out_file;
+}
 
-    for (const auto &circuit_node : circuit) {
-        if (circuit_node.gate_type == INPUT_GATE_T) {
-            BDD_node = InputGate(circuit_node.label);
-        } else if (circuit_node.gate_type == NOT_GATE_T) {
-            BDD_node = NotGate(circuit_node.input_id_list);
-        } else if (circuit_node.gate_type == AND_GATE_T) {
-            BDD_node = AndGate(circuit_node.input_id_list);
-        } else if (circuit_node.gate_type == OR_GATE_T) {
-            BDD_node = OrGate(circuit_node.input_id_list);
-        } else if (circuit_node.gate_type == NAND_GATE_T) {
-            BDD_node = NandGate(circuit_node.input_id_list);
-        } else if (circuit_node.gate_type == NOR_GATE_T) {
-            BDD_node = NorGate(circuit_node.input_id_list);
-        } else if (circuit_node.gate_type == XOR_GATE_T) {
-            BDD_node = XorGate(circuit_node.input_id_list);
-        } else if (circuit_node.gate_type == BUFFER_GATE_T) {
-            BDD_node = findBddId(*circuit_node.input_id_list.begin());
+std::vector<unique_ID_t> CircuitToBDD::KeptGates(const Circuit &circuit) {
+    /* Gates driving an OUTPUT or FLIP FLOP, or the selected outputs, are kept */
+    std::vector<unique_ID_t> kept_gates;
+    if (selected_outputs.empty()) {
+        for (const auto &root : circuit.GetRoots()) {
+            kept_gates.insert(kept_gates.end(), circuit.GetFanins(root).begin(), circuit.GetFanins(root).end());
+        }
+    } else {
+        for (const auto &output_label : selected_outputs) {
+            unique_ID_t gate = circuit.FindGate(output_label);
+            if (gate == NO_CIRCUIT) {
+                throw std::runtime_error("There is no gate with the label " + output_label + "!");
+            }
+            kept_gates.push_back(gate);
         }
+    }
+    return kept_gates;
+}
+
+void CircuitToBDD::BuildGates(const Circuit &circuit, std::ofstream *bdd_out_file) {
+    ClassProject::BDD_ID BDD_node = NO_BDD;
+
+    label_table = circuit.GetLabelTable();
+    /* Circuit IDs are handed out densely, so both mappings are plain vectors */
+    node_to_bdd_id.assign(circuit.Size(), NO_BDD);
+    label_to_bdd_id.assign(label_table->Size(), NO_BDD);
 
-        /* OUTPUT or FLIP FLOP gates do not generate a BDD */
-        if (!((circuit_node.gate_type == OUTPUT_GATE_T) | (circuit_node.gate_type == FLIP_FLOP_GATE_T))) {
-            node_to_bdd_id.insert(std::pair<unique_ID_t, ClassProject::BDD_ID>(circuit_node.id, BDD_node));
-            label_to_bdd_id.insert(std::pair<label_t, ClassProject::BDD_ID>(circuit_node.label, BDD_node));
-            bdd_out_file << BDD_node << "," << circuit_node.label << std::endl;
+    std::vector<unique_ID_t> kept_gates = KeptGates(circuit);
+    std::vector<bool> keep(circuit.Size(), false);
+    for (const auto gate : kept_gates) {
+        keep[gate] = true;
+    }
+
+    /* Only the cone of influence of the selected outputs is built, so only its inputs become variables */
+    std::vector<bool> in_cone = selected_outputs.empty() ? std::vector<bool>(circuit.Size(), true)
+                                                         : circuit.GetFaninCone(kept_gates);
+
+    /* Every other gate is released after its last consumer in the cone */
+    std::vector<size_t> pending_fanouts(circuit.Size(), 0);
+    for (const auto &circuit_node : circuit.GetNodes()) {
+        for (const auto output : circuit.GetFanouts(circuit_node.id)) {
+            if (in_cone[output]) pending_fanouts[circuit_node.id]++;
         }
     }
 
-    bdd_out_file.close();
-}
+    /* Spans cover batches of gates, named by the last gate of the batch */
+    uint64_t batch_start = ClassProject::Trace::enabled() ? ClassProject::Trace::now() : 0;
+    size_t batch_gates = 0;
+    unique_ID_t batch_last = 0;
 
+    for (const auto &circuit_node : circuit.GetNodes()) {
+        if (!in_cone[circuit_node.id]) {
+            continue;
+        }
+        if (batch_start != 0 && batch_gates == TRACE_BATCH) {
+            uint64_t now = ClassProject::Trace::now();
+            ClassProject::Trace::record("gates", "build", batch_start, now, static_cast<int64_t>(batch_last));
+            batch_start = now;
+            batch_gates = 0;
+        }
+        batch_gates++;
+        batch_last = circuit_node.id;
+        id_range_t inputs = circuit.GetFanins(circuit_node.id);
+        switch (circuit_node.gate_type) {
+            case gate_type_t::INPUT:
+                BDD_node = InputGate(circuit_node.label);
+                break;
+            case gate_type_t::NOT:
+                BDD_node = NotGate(inputs);
+                break;
+            case gate_type_t::AND:
+                BDD_node = AndGate(inputs);
+                break;
+            case gate_type_t::OR:
+                BDD_node = OrGate(inputs);
+                break;
+            case gate_type_t::NAND:
+                BDD_node = NandGate(inputs);
+                break;
+            case gate_type_t::NOR:
+                BDD_node = NorGate(inputs);
+                break;
+            case gate_type_t::XOR:
+                BDD_node = XorGate(inputs);
+                break;
+            case gate_type_t::BUFFER:
+                BDD_node = findBddId(inputs[0]);
+                break;
+            case gate_type_t::CONST0:
+                BDD_node = bdd_manager->False();
+                break;
+            case gate_type_t::CONST1:
+                BDD_node = bdd_manager->True();
+                break;
+            case gate_type_t::OUTPUT:
+            case gate_type_t::FLIP_FLOP:
+                /* OUTPUT or FLIP FLOP gates do not generate a BDD */
+                continue;
+        }
 
-ClassProject::BDD_ID CircuitToBDD::findBddId(unique_ID_t circuit_node) {
+        if (!cut_points.empty()) {
+            auto cut = cut_points.find(circuit_node.id);
+            if (cut != cut_points.end()) {
+                cut_functions[circuit_node.id] = BDD_node;
+                if (!cut_check || cut_check(circuit_node.id, BDD_node)) {
+                    BDD_node = cut->second;
+                }
+            }
+        }
 
-    auto bdd_id_it = node_to_bdd_id.find(circuit_node);
+        node_to_bdd_id[circuit_node.id] = BDD_node;
+        if (circuit_node.label != NO_LABEL) {
+            label_to_bdd_id[circuit_node.label] = BDD_node;
+        }
+        if (bdd_out_file != nullptr && gc_manager == nullptr && circuit_node.label != NO_LABEL) {
+            *bdd_out_file << BDD_node << "," << label_table->GetLabel(circuit_node.label) << "\n";
+        }
+        PipelineOutput(circuit, circuit_node.id, BDD_node);
+
+        /* The inputs whose last consumer this was are not needed anymore */
+        for (const auto input : inputs) {
+            if (--pending_fanouts[input] == 0 && !keep[input]) {
+                label_id_t input_label = circuit.GetNodes()[input].label;
+                if (input_label != NO_LABEL && label_to_bdd_id[input_label] == node_to_bdd_id[input]) {
+                    label_to_bdd_id[input_label] = NO_BDD;
+                }
+                node_to_bdd_id[input] = NO_BDD;
+            }
+        }
 
-    if (bdd_id_it != node_to_bdd_id.end()) {
-        return bdd_id_it->second;
-    } else {
-        throw std::runtime_error("Destination node ID is not part of the circuit graph!");
+        if (gc_manager != nullptr && gc_manager->uniqueTableSize() > gc_threshold) {
+            CollectGarbage();
+        }
+    }
+    if (batch_start != 0 && batch_gates != 0) {
+        ClassProject::Trace::record("gates", "build", batch_start, ClassProject::Trace::now(),
+                                    static_cast<int64_t>(batch_last));
+    }
+
+    /* Collections renumber the nodes, so the IDs of the kept gates are only final now */
+    if (bdd_out_file != nullptr && gc_manager != nullptr) {
+        for (const auto &circuit_node : circuit.GetNodes()) {
+            if (keep[circuit_node.id]) {
+                *bdd_out_file << node_to_bdd_id[circuit_node.id] << "," << label_table->GetLabel(circuit_node.label)
+                             << "\n";
+            }
+        }
     }
 }
 
+void CircuitToBDD::StartPipeline(const Circuit &circuit) {
+    if (pipelined_labels.empty()) {
+        return;
+    }
+    BddWriter::CreateDirectories(result_dir, pipelined_formats);
 
-ClassProject::BDD_ID CircuitToBDD::InputGate(const label_t &label) {
-    return bdd_manager->createVar(label);
+    pipelined_gates.assign(circuit.Size(), false);
+    for (const auto &label : pipelined_labels) {
+        unique_ID_t gate = circuit.FindGate(label);
+        if (gate == NO_CIRCUIT) {
+            throw std::runtime_error("Destination node UUID is not part of the circuit graph!");
+        }
+        pipelined_gates[gate] = true;
+    }
+    pipelined_pushes = 0;
+    pipelined_hashes.clear();
+    pipeline = make_unique<BddPipeline>(result_dir, pipelined_formats);
 }
 
+void CircuitToBDD::PipelineOutput(const Circuit &circuit, unique_ID_t gate, ClassProject::BDD_ID root) {
+    if (pipeline != nullptr && pipelined_gates[gate]) {
+        BddWriter bdds(*bdd_manager, {circuit.GetLabel(gate)}, {root});
+        pipelined_hashes[circuit.GetLabel(gate)] = bdds.GetSnapshot().root_hashes.front();
+        pipeline->Push(std::move(bdds));
+        pipelined_pushes++;
+    }
+}
 
-ClassProject::BDD_ID CircuitToBDD::NotGate(const set_of_circuit_t &inputNodes) {
-    unique_ID_t node = *inputNodes.begin();
-    return bdd_manager->neg(findBddId(node));
+void CircuitToBDD::SetPipelinedPrint(const std::set<label_t> &output_labels, unsigned int formats) {
+    pipelined_labels = output_labels;
+    pipelined_formats = formats;
 }
 
+void CircuitToBDD::FinishPrint() {
+    if (pipeline == nullptr) {
+        return;
+    }
+    std::unique_ptr<BddPipeline> finished = std::move(pipeline);
+    finished->Finish();
+    if (pipelined_pushes != pipelined_labels.size()) {
+        throw std::runtime_error("Destination node UUID is not part of the circuit graph!");
+    }
+    WriteHashes(pipelined_hashes);
+}
 
-ClassProject::BDD_ID CircuitToBDD::AndGate(set_of_circuit_t inputNodes) {
-    auto it = inputNodes.begin();
-    ClassProject::BDD_ID first_op, second_op;
+void CircuitToBDD::WriteHashes(const std::map<label_t, uint64_t> &hashes) {
+    std::ofstream hash_file(result_dir + "/" + HASH_FILE);
+    if (!hash_file.is_open()) {
+        throw std::runtime_error("Unable to open Hash File!");
+    }
 
-    /* Get the ClassProject::BDD_ID of first elements */
-    first_op = findBddId(*it);
-    inputNodes.erase(it);
+    hash_file << "Bench Label,Hash" << std::endl;
+    for (const auto &hash : hashes) {
+        if (hash.second != 0) {
+            hash_file << hash.first << "," << std::hex << std::setw(16) << std::setfill('0') << hash.second << std::dec
+                      << "\n";
+        }
+    }
+}
 
-    while (!inputNodes.empty()) {
-        it = inputNodes.begin();
-        second_op = findBddId(*it);
-        inputNodes.erase(it);
+void CircuitToBDD::SetSelectedOutputs(const std::set<label_t> &output_labels) {
+    selected_outputs = output_labels;
+}
 
-        first_op = bdd_manager->and2(first_op, second_op);
-    }
+void CircuitToBDD::SetCutPoints(const std::unordered_map<unique_ID_t, ClassProject::BDD_ID> &cuts) {
+    cut_points = cuts;
+}
 
-    /* Return the ClassProject::BDD_ID equivalent to the AND of all inputs */
-    return first_op;
+void CircuitToBDD::SetCutCheck(std::function<bool(unique_ID_t, ClassProject::BDD_ID)> check) {
+    cut_check = std::move(check);
 }
 
+ClassProject::BDD_ID CircuitToBDD::GetCutFunction(unique_ID_t id) {
+    auto cut_function = cut_functions.find(id);
+    if (cut_function == cut_functions.end()) {
+        throw std::runtime_error("The gate was not cut!");
+    }
+    return cut_function->second;
+}
 
-ClassProject::BDD_ID CircuitToBDD::OrGate(set_of_circuit_t inputNodes) {
-    auto it = inputNodes.begin();
-    ClassProject::BDD_ID first_op, second_op;
+void CircuitToBDD::EnableGarbageCollection(size_t min_nodes) {
+    gc_manager = std::dynamic_pointer_cast<ClassProject::Manager>(bdd_manager);
+    if (gc_manager == nullptr) {
+        throw std::runtime_error("Garbage collection needs a ClassProject::Manager!");
+    }
+    gc_min_nodes = min_nodes;
+    gc_threshold = min_nodes;
+}
 
-    /* Get the ClassProject::BDD_ID of first elements */
-    first_op = findBddId(*it);
-    inputNodes.erase(it);
+void CircuitToBDD::CollectGarbage() {
+    /* Everything this class still refers to is a root; the roots are written back in the same order */
+    std::vector<ClassProject::BDD_ID> roots;
+    for (const auto bdd_id : node_to_bdd_id) {
+        if (bdd_id != NO_BDD) roots.push_back(bdd_id);
+    }
+    for (const auto bdd_id : label_to_bdd_id) {
+        if (bdd_id != NO_BDD) roots.push_back(bdd_id);
+    }
+    for (const auto &binding : input_bindings) {
+        roots.push_back(binding.second);
+    }
+    for (const auto &cut : cut_points) {
+        roots.push_back(cut.second);
+    }
+    for (const auto &cut_function : cut_functions) {
+        roots.push_back(cut_function.second);
+    }
 
-    while (!inputNodes.empty()) {
-        it = inputNodes.begin();
-        second_op = findBddId(*it);
-        inputNodes.erase(it);
+    gc_freed_nodes += gc_manager->garbageCollect(roots);
+    gc_runs++;
 
-        first_op = bdd_manager->or2(first_op, second_op);
+    auto root = roots.begin();
+    for (auto &bdd_id : node_to_bdd_id) {
+        if (bdd_id != NO_BDD) bdd_id = *root++;
+    }
+    for (auto &bdd_id : label_to_bdd_id) {
+        if (bdd_id != NO_BDD) bdd_id = *root++;
+    }
+    for (auto &binding : input_bindings) {
+        binding.second = *root++;
+    }
+    for (auto &cut : cut_points) {
+        cut.second = *root++;
+    }
+    for (auto &cut_function : cut_functions) {
+        cut_function.second = *root++;
     }
 
-    /* Return the ClassProject::BDD_ID equivalent to the OR of all inputs */
-    return first_op;
+    /* Collect again once the live nodes have doubled */
+    gc_threshold = std::max(gc_min_nodes, 2 * gc_manager->uniqueTableSize());
 }
 
-ClassProject::BDD_ID CircuitToBDD::NandGate(set_of_circuit_t inputNodes) {
-    auto it = inputNodes.begin();
-    ClassProject::BDD_ID first_op, second_op;
+size_t CircuitToBDD::GetGarbageCollectionRuns() const {
+    return gc_runs;
+}
+
+size_t CircuitToBDD::GetFreedNodes() const {
+    return gc_freed_nodes;
+}
 
-    /* Get the ClassProject::BDD_ID of first elements */
-    it = inputNodes.begin();
-    first_op = findBddId(*it);
-    inputNodes.erase(it);
+size_t CircuitToBDD::GetPrintedNodes() const {
+    return printed_nodes;
+}
 
-    if (inputNodes.size() == 1) {
-        it = inputNodes.begin();
-        second_op = findBddId(*it);
-        inputNodes.erase(it);
+ClassProject::BDD_ID CircuitToBDD::findBddId(unique_ID_t circuit_node) {
 
-        /* Create the NAND BDD node for the first two elements */
-        first_op = bdd_manager->nand2(first_op, second_op);
+    if (circuit_node < node_to_bdd_id.size() && node_to_bdd_id[circuit_node] != NO_BDD) {
+        return node_to_bdd_id[circuit_node];
     } else {
-        /* AND of all inputs, to use as the second operator of the NAND gate */
-        second_op = AndGate(inputNodes);
-        /* Create the NAND BDD node */
-        first_op = bdd_manager->nand2(first_op, second_op);
+        throw std::runtime_error("Destination node ID is not part of the circuit graph!");
     }
+}
 
-    /* Return the ClassProject::BDD_ID equivalent to the NAND of all inputs */
-    return first_op;
+
+void CircuitToBDD::SetInputVariables(const std::unordered_map<label_t, ClassProject::BDD_ID> &bindings) {
+    input_bindings = bindings;
 }
 
-ClassProject::BDD_ID CircuitToBDD::NorGate(set_of_circuit_t inputNodes) {
-    auto it = inputNodes.begin();
-    ClassProject::BDD_ID first_op, second_op;
+ClassProject::BDD_ID CircuitToBDD::findBddIdByLabel(const label_t &label) {
+    label_id_t label_id = (label_table != nullptr) ? label_table->Find(label) : NO_LABEL;
+    return (label_id < label_to_bdd_id.size()) ? label_to_bdd_id[label_id] : NO_BDD;
+}
 
-    /* Get the ClassProject::BDD_ID of first elements */
-    it = inputNodes.begin();
-    first_op = findBddId(*it);
-    inputNodes.erase(it);
+ClassProject::BDD_ID CircuitToBDD::GetBddId(const label_t &label) {
 
-    if (inputNodes.size() == 1) {
-        it = inputNodes.begin();
-        second_op = findBddId(*it);
-        inputNodes.erase(it);
+    ClassProject::BDD_ID bdd_id = findBddIdByLabel(label);
 
-        /* Create the NOR BDD node for the first two elements */
-        first_op = bdd_manager->nor2(first_op, second_op);
+    if (bdd_id != NO_BDD) {
+        return bdd_id;
     } else {
-        /* OR of all inputs, to use as the second operator of the NAND gate */
-        second_op = OrGate(inputNodes);
-        /* Create the NOR BDD node */
-        first_op = bdd_manager->nor2(first_op, second_op);
+        throw std::runtime_error("There is no BDD for the label " + label + "!");
     }
+}
 
-    /* Return the ClassProject::BDD_ID equivalent to the NOR of all inputs */
-    return first_op;
+
+ClassProject::BDD_ID CircuitToBDD::InputGate(label_id_t label) {
+    const label_t &input_label = label_table->GetLabel(label);
+    auto binding = input_bindings.find(input_label);
+    if (binding != input_bindings.end()) {
+        return binding->second;
+    }
+    return bdd_manager->createVar(input_label);
 }
 
-ClassProject::BDD_ID CircuitToBDD::XorGate(set_of_circuit_t inputNodes) {
-    auto it = inputNodes.begin();
-    ClassProject::BDD_ID first_op, second_op;
 
-    /* Get the ClassProject::BDD_ID of first elements */
-    first_op = findBddId(*it);
-    inputNodes.erase(it);
+ClassProject::BDD_ID CircuitToBDD::NotGate(id_range_t inputNodes) {
+    return bdd_manager->neg(findBddId(inputNodes[0]));
+}
 
-    while (!inputNodes.empty()) {
-        it = inputNodes.begin();
-        second_op = findBddId(*it);
-        inputNodes.erase(it);
 
-        first_op = bdd_manager->xor2(first_op, second_op);
+size_t CircuitToBDD::BddSize(ClassProject::BDD_ID root) {
+    /* ReduceGate sizes every operand and intermediate result, a set per call would dominate wide gates */
+    if (node_counter != nullptr) {
+        return node_counter->nodeCount(root);
     }
-
-    /* Return the ClassProject::BDD_ID equivalent to the XOR of all inputs */
-    return first_op;
+    std::set<ClassProject::BDD_ID> nodes_of_root;
+    bdd_manager->findNodes(root, nodes_of_root);
+    return nodes_of_root.size();
 }
 
-void CircuitToBDD::PrintBDD(const std::set<label_t> &output_labels) {
 
-    if ((!(std::filesystem::exists(result_dir + "/txt")) &
-         !(std::filesystem::create_directory(result_dir + "/txt")))
-        & (!(std::filesystem::exists(result_dir + "/dot")) &
-           !(std::filesystem::create_directory(result_dir + "/dot")))) {
-        throw std::runtime_error("Unable to create directories 'txt' and 'dot' for the output!");
+ClassProject::BDD_ID CircuitToBDD::ReduceGate(id_range_t inputNodes, binary_operation_t operation) {
+    ClassProject::ManagerInterface &manager = *bdd_manager;
+
+    /* Two inputs, the common case, need no ordering */
+    if (inputNodes.size() <= 2) {
+        ClassProject::BDD_ID first_op = findBddId(inputNodes[0]);
+        if (inputNodes.size() == 1) {
+            return first_op;
+        }
+        return (manager.*operation)(first_op, findBddId(inputNodes[1]));
     }
 
-    for (const auto &output_label : output_labels) {
+    /* Always combine the two smallest operands, so large intermediate BDDs are built as late as possible */
+    typedef std::pair<size_t, ClassProject::BDD_ID> sized_operand_t;
+    std::priority_queue<sized_operand_t, std::vector<sized_operand_t>, std::greater<>> operands;
+    for (const auto input : inputNodes) {
+        ClassProject::BDD_ID operand = findBddId(input);
+        operands.emplace(BddSize(operand), operand);
+    }
 
-        auto output_id_it = label_to_bdd_id.find(output_label);
+    while (operands.size() > 1) {
+        ClassProject::BDD_ID first_op = operands.top().second;
+        operands.pop();
+        ClassProject::BDD_ID second_op = operands.top().second;
+        operands.pop();
 
-        if (output_id_it != label_to_bdd_id.end()) {
+        ClassProject::BDD_ID result = (manager.*operation)(first_op, second_op);
+        operands.emplace(BddSize(result), result);
+    }
 
-            std::string dot_file_name = result_dir + "/dot/" + std::string(output_label) + ".dot";
-            std::string txt_file_name = result_dir + "/txt/" + std::string(output_label) + ".txt";
+    return operands.top().second;
+}
 
-            std::ofstream bdd_out_dot_file(dot_file_name);
-            std::ofstream bdd_out_txt_file(txt_file_name);
 
-            if (!bdd_out_dot_file.is_open() | !bdd_out_txt_file.is_open()) {
-                throw std::runtime_error("Unable to open Log File!");
-            }
+ClassProject::BDD_ID CircuitToBDD::AndGate(id_range_t inputNodes) {
+    /* Return the ClassProject::BDD_ID equivalent to the AND of all inputs */
+    return ReduceGate(inputNodes, &ClassProject::ManagerInterface::and2);
+}
 
-            output_nodes.clear();
-            output_vars.clear();
-            bdd_manager->findNodes(output_id_it->second, output_nodes);
-            bdd_manager->findVars(output_id_it->second, output_vars);
 
-            dumpBddText(bdd_out_txt_file);
-            dumpBddDot(bdd_out_dot_file);
+ClassProject::BDD_ID CircuitToBDD::OrGate(id_range_t inputNodes) {
+    /* Return the ClassProject::BDD_ID equivalent to the OR of all inputs */
+    return ReduceGate(inputNodes, &ClassProject::ManagerInterface::or2);
+}
 
-            bdd_out_dot_file.close();
-            bdd_out_txt_file.close();
+ClassProject::BDD_ID CircuitToBDD::NandGate(id_range_t inputNodes) {
+    /* Return the ClassProject::BDD_ID equivalent to the NAND of all inputs */
+    return bdd_manager->neg(AndGate(inputNodes));
+}
 
-        } else {
-            throw std::runtime_error("Destination node UUID is not part of the circuit graph!");
-        }
-    }
+ClassProject::BDD_ID CircuitToBDD::NorGate(id_range_t inputNodes) {
+    /* Return the ClassProject::BDD_ID equivalent to the NOR of all inputs */
+    return bdd_manager->neg(OrGate(inputNodes));
 }
 
-void CircuitToBDD::dumpBddText(std::ostream &out) {
-    for (auto it = output_nodes.rbegin(); it != output_nodes.rend(); ++it) {
-        if (bdd_manager->isConstant(*it)) {
-            out << "Terminal Node: " << (*it) << "\n";
-        } else {
-            out << "Variable Node: " << (*it)
-                << " Top Var Id: " << bdd_manager->topVar(*it)
-                << " Top Var Name: " << bdd_manager->getTopVarName(bdd_manager->topVar(*it))
-                << " Low: " << bdd_manager->coFactorFalse(*it)
-                << " High: " << bdd_manager->coFactorTrue(*it) << "\n";
-        }
-    }
+ClassProject::BDD_ID CircuitToBDD::XorGate(id_range_t inputNodes) {
+    /* Return the ClassProject::BDD_ID equivalent to the XOR of all inputs */
+    return ReduceGate(inputNodes, &ClassProject::ManagerInterface::xor2);
 }
 
-void CircuitToBDD::dumpBddDot(std::ostream &out) {
-    out << "digraph BDD {\n";
-    out << "center = true;\n";
-    out << "{ rank = same; { node [style=invis]; \"T\" };\n";
-    out << " { node [shape=box,fontsize=12]; \"0\"; }\n";
-    out << "  { node [shape=box,fontsize=12]; \"1\"; }\n}\n";
-    for (const auto var : output_vars) {
-        out << R"({ rank=same; { node [shape=plaintext,fontname="Times Italic",fontsize=12] ")"
-            << bdd_manager->getTopVarName(var) << "\" };";
-        for (unsigned long node : output_nodes) {
-            if (bdd_manager->topVar(node) == var) {
-                out << "\"" << node << "\";";
-            }
-        }
-        out << "}\n";
-    }
-    out << "edge [style = invis]; {";
-    for (const auto var : output_vars) {
-        out << "\"" << bdd_manager->getTopVarName(var) << "\" -> ";
-    }
-    out << "\"T\"; }\n";
-    for (const auto node : output_nodes) {
-        if (!bdd_manager->isConstant(node)) {
-            out << "\"" << node << "\" -> \"" << bdd_manager->coFactorTrue(node)
-                << "\" [style=solid,arrowsize=\".75\"];\n";
-            out << "\"" << node << "\" -> \"" << bdd_manager->coFactorFalse(node)
-                << "\" [style=dashed,arrowsize=\".75\"];\n";
+void CircuitToBDD::PrintBDD(const std::set<label_t> &output_labels, unsigned int threads, bool combined,
+                            unsigned int formats) {
+    ClassProject::TraceSpan span("printBDD", "print", static_cast<int64_t>(output_labels.size()));
+    BddWriter::CreateDirectories(result_dir, formats);
+
+    std::vector<label_t> labels(output_labels.begin(), output_labels.end());
+    std::vector<ClassProject::BDD_ID> roots;
+    for (const auto &output_label : labels) {
+        ClassProject::BDD_ID output_id = findBddIdByLabel(output_label);
+        if (output_id == NO_BDD) {
+            throw std::runtime_error("Destination node UUID is not part of the circuit graph!");
         }
+        roots.push_back(output_id);
     }
-    out << "}\n";
-}
 
+    BddWriter writer(*bdd_manager, labels, roots);
+    printed_nodes = writer.GetSnapshot().nodes.size();
+    if (combined) {
+        writer.WriteCombined(result_dir, COMBINED_FILE, formats);
+    } else {
+        writer.WriteRoots(result_dir, threads, formats);
+    }
 
+    std::map<label_t, uint64_t> hashes;
+    for (size_t r = 0; r < labels.size(); r++) {
+        hashes[labels[r]] = writer.GetSnapshot().root_hashes[r];
+    }
+    WriteHashes(hashes);
+}
@@ -6,10 +6,14 @@
 #pragma once
 
 #include "BenchParser.hpp"
-#include "../ManagerInterface.h"
+#include "BddPipeline.hpp"
+#include "../Manager.h"
+#include "../Trace.h"
 #include <iostream>
 #include <fstream>
 #include <filesystem>
+#include <functional>
+#include <map>
 
 
 /**
@@ -31,32 +35,198 @@ public:
 
     /**
      * \brief Generates a BDD from the circuit nodes provided
-     * \param Topologically sorted list containing the circuit nodes
+     * \param Topologically sorted circuit
      * \return none
      *
      *  Generates the calls to the BDD package in order to
-     *   generate the BDD equivalent to the provided circuit.
+     *   generate the BDD equivalent to the provided circuit. The BDD of a gate is
+     *   released once its last consumer is built, only the gates driving an OUTPUT
+     *   or FLIP FLOP are kept.
      */
-    void GenerateBDD(const std::list<circuit_node_t> &circuit, const std::string& benchmark_file);
+    void GenerateBDD(const Circuit &circuit, const std::string& benchmark_file);
+
+    /**
+     * \brief Generates the BDDs like GenerateBDD, without writing the results directory
+     * \param Topologically sorted circuit
+     * \return none
+     */
+    void BuildBDD(const Circuit &circuit);
+
+    /**
+     * \brief Generates the BDDs of the outputs on several threads
+     * \param circuit is the topologically sorted circuit
+     * \param benchmark_file is the path to the bench file, used for the results directory
+     * \param threads is the number of worker threads
+     * \return none
+     *
+     *  The outputs are partitioned over the workers by the size of their cone of influence.
+     *   Every worker builds only the cones of its outputs in a manager of its own, with the
+     *   variables created in the same order, and the results are imported into this manager.
+     *   Only the output gates are kept, see SetSelectedOutputs.
+     *
+     * \throws std::runtime_error if the manager is not a ClassProject::Manager
+     */
+    void GenerateBDDParallel(const Circuit &circuit, const std::string &benchmark_file, unsigned int threads);
 
 
     /**
      * \brief Print the generated BDD in text and dot format
      * \param The set of output labels to print a BDD for
+     * \param threads is the number of threads writing the files
+     * \param combined writes all outputs into one file named COMBINED_FILE instead of one file per output
+     * \param formats is a mask of bdd_format_t
+     * \return none
+     *
+     *  All outputs are collected in one traversal, see BddWriter. The structural hash of every
+     *   output is logged to HASH_FILE.
+     */
+    void PrintBDD(const std::set<label_t> &output_labels, unsigned int threads = 1, bool combined = false,
+                  unsigned int formats = TEXT_FORMAT | DOT_FORMAT);
+
+    /**
+     * \brief Prints the BDDs of outputs while GenerateBDD is still building the others
+     * \param output_labels is the set of output labels to print a BDD for
+     * \param formats is a mask of bdd_format_t
+     * \return none
+     *
+     *  Must be called before GenerateBDD or GenerateBDDParallel. The BDD of an output is final
+     *   once its gate is built, so it is copied out of the manager right away and written by a
+     *   BddPipeline thread while the build goes on. The files are the ones PrintBDD writes, if
+     *   garbage collection is enabled they show the BDD_IDs from before later collections.
+     *   FinishPrint waits for the writer.
+     */
+    void SetPipelinedPrint(const std::set<label_t> &output_labels, unsigned int formats = TEXT_FORMAT | DOT_FORMAT);
+
+    /**
+     * \brief Waits until all outputs passed to SetPipelinedPrint are written
+     * \param none
+     * \return none
+     *
+     * \throws std::runtime_error if an output was not built or a file cannot be written
+     */
+    void FinishPrint();
+
+    static constexpr const char *COMBINED_FILE = "outputs"; ///< Name of the txt and dot file of a combined print
+    static constexpr const char *HASH_FILE = "hashes.csv";  ///< Structural hash of every printed output
+
+    /**
+     * \brief Binds INPUT gates to already existing BDD variables
+     * \param bindings maps INPUT gate labels to the BDD variable to use instead of creating a new one
+     * \return none
+     *
+     *  Must be called before GenerateBDD. Allows building a circuit on top of the
+     *   variables of e.g. a ClassProject::Reachability state machine.
+     */
+    void SetInputVariables(const std::unordered_map<label_t, ClassProject::BDD_ID> &bindings);
+
+    /**
+     * \brief Returns the BDD_ID generated for the gate with the given label
+     * \param label is label_t, the label of a gate driving an OUTPUT or FLIP FLOP
+     * \return ClassProject::BDD_ID
+     */
+    ClassProject::BDD_ID GetBddId(const label_t &label);
+
+    /**
+     * \brief Restricts GenerateBDD to the cone of influence of the given gates
+     * \param output_labels are the labels of the gates to build, an empty set builds the whole circuit
+     * \return none
+     *
+     *  Must be called before GenerateBDD. Only the transitive fan-in of the given gates is built,
+     *   so variables are created only for the INPUT gates of that cone, in topological order,
+     *   and only the given gates are kept for GetBddId and PrintBDD.
+     */
+    void SetSelectedOutputs(const std::set<label_t> &output_labels);
+
+    /**
+     * \brief Replaces the BDDs of some gates by given BDDs, usually fresh cut point variables
+     * \param cut_points maps circuit IDs of gates to the BDD their users see instead of the gate's own BDD
+     * \return none
+     *
+     *  Must be called before GenerateBDD. The BDD of a cut gate is still built from its inputs
+     *   and can be read back with GetCutFunction, so the cut can be justified afterwards.
+     */
+    void SetCutPoints(const std::unordered_map<unique_ID_t, ClassProject::BDD_ID> &cut_points);
+
+    /**
+     * \brief Decides while building whether a gate passed to SetCutPoints is cut
+     * \param check is called with the circuit ID and the BDD of the gate, built with the earlier cuts, in
+     *   topological order. The gate is cut if it returns true
+     * \return none
+     *
+     *  Without a check every gate passed to SetCutPoints is cut.
+     */
+    void SetCutCheck(std::function<bool(unique_ID_t, ClassProject::BDD_ID)> check);
+
+    /**
+     * \brief Returns the BDD a cut gate computed from its inputs
+     * \param id is the circuit ID of a gate passed to SetCutPoints
+     * \return ClassProject::BDD_ID
+     *
+     * \throws std::runtime_error if the gate was not cut or not built
+     */
+    ClassProject::BDD_ID GetCutFunction(unique_ID_t id);
+
+    /**
+     * \brief Enables garbage collection of released gate BDDs while GenerateBDD runs
+     * \param min_nodes is the manager size below which no collection runs
      * \return none
+     *
+     *  Collections renumber every BDD node, so this may only be used if the manager is a
+     *   ClassProject::Manager that no one else holds BDD_IDs of. Must be called before GenerateBDD.
+     *
+     * \throws std::runtime_error if the manager is not a ClassProject::Manager
+     */
+    void EnableGarbageCollection(size_t min_nodes);
+
+    /**
+     * \brief Returns the number of garbage collections run by GenerateBDD
+     * \return size_t
+     */
+    size_t GetGarbageCollectionRuns() const;
+
+    /**
+     * \brief Returns the number of nodes freed by all garbage collections
+     * \return size_t
      */
-    void PrintBDD(const std::set<label_t> &output_labels);
+    size_t GetFreedNodes() const;
+
+    /**
+     * \brief Returns the number of distinct nodes written by the last PrintBDD
+     * \return size_t
+     */
+    size_t GetPrintedNodes() const;
 
 private:
 
-    std::unordered_map<unique_ID_t, ClassProject::BDD_ID> node_to_bdd_id; ///< Mapping from circuit node's unique ID to its BDD ID
-    std::unordered_map<label_t, ClassProject::BDD_ID> label_to_bdd_id; ///< Mapping from node's label to its BDD ID
+    static constexpr ClassProject::BDD_ID NO_BDD = SIZE_MAX; ///< Marks a node without a BDD
+    static constexpr size_t TRACE_BATCH = 256; ///< Gates per traced span of a build, one span per gate is too many
+
+    std::shared_ptr<const LabelTable> label_table; ///< Labels of the circuit nodes
+    std::vector<ClassProject::BDD_ID> node_to_bdd_id; ///< Mapping from circuit node's unique ID to its BDD ID
+    std::vector<ClassProject::BDD_ID> label_to_bdd_id; ///< Mapping from node's interned label to its BDD ID
+    std::unordered_map<label_t, ClassProject::BDD_ID> input_bindings; ///< INPUT gates bound to existing variables
+    std::set<label_t> selected_outputs; ///< Gates to build the cone of influence for, empty for the whole circuit
+    std::unordered_map<unique_ID_t, ClassProject::BDD_ID> cut_points;    ///< BDDs replacing the BDD of a gate
+    std::unordered_map<unique_ID_t, ClassProject::BDD_ID> cut_functions; ///< BDDs the cut gates computed
+    std::function<bool(unique_ID_t, ClassProject::BDD_ID)> cut_check; ///< Decides which cut points are used
+
+    std::shared_ptr<ClassProject::Manager> gc_manager; ///< Set if garbage collection is enabled
+    size_t gc_min_nodes = 0;   ///< Manager size below which no collection runs
+    size_t gc_threshold = 0;   ///< Manager size that triggers the next collection
+    size_t gc_runs = 0;        ///< Number of collections run
+    size_t gc_freed_nodes = 0; ///< Number of nodes freed by all collections
 
     shared_ptr<ClassProject::ManagerInterface> bdd_manager{};
+    ClassProject::Manager *node_counter = nullptr; ///< bdd_manager if it is a ClassProject::Manager, for BddSize
     std::string result_dir; ///< Directory where the results are stored
+    size_t printed_nodes = 0; ///< Distinct nodes written by the last PrintBDD
 
-    std::set<ClassProject::BDD_ID> output_nodes;
-    std::set<ClassProject::BDD_ID> output_vars;
+    std::set<label_t> pipelined_labels;     ///< Outputs to print while building, see SetPipelinedPrint
+    unsigned int pipelined_formats = 0;     ///< Mask of bdd_format_t for the pipelined print
+    std::vector<bool> pipelined_gates;      ///< Gates of the pipelined outputs, by circuit ID
+    size_t pipelined_pushes = 0;            ///< Outputs handed to the pipeline so far
+    std::map<label_t, uint64_t> pipelined_hashes; ///< Structural hash of every pipelined output
+    std::unique_ptr<BddPipeline> pipeline;  ///< Writer of the pipelined print, nullptr if there is none
 
 
     /**
@@ -68,62 +238,139 @@ private:
     ClassProject::BDD_ID findBddId(unique_ID_t circuit_node);
 
     /**
-     * \brief Generates the BDD node equivalent to a variable with label "label".
+     * \brief Creates the results directory and the CSV mapping BDD_IDs to bench labels
+     * \param benchmark_file is the path to the bench file
+     * \return std::ofstream of the CSV, the header is already written
+     */
+    std::ofstream OpenResults(const std::string &benchmark_file);
+
+    /**
+     * \brief Returns the gates whose BDDs are kept, the selected outputs or the gates driving an OUTPUT or FLIP FLOP
+     * \param circuit is the topologically sorted circuit
+     * \return std::vector<unique_ID_t>
+     */
+    std::vector<unique_ID_t> KeptGates(const Circuit &circuit);
+
+    /**
+     * \brief Generates the BDDs of all gates in the cone of influence
+     * \param circuit is the topologically sorted circuit
+     * \param bdd_out_file is the CSV to log the BDD_ID of every gate to, nullptr for none
+     * \return none
+     */
+    void BuildGates(const Circuit &circuit, std::ofstream *bdd_out_file);
+
+    /**
+     * \brief Starts the writer of the pipelined print, if SetPipelinedPrint was called
+     * \param circuit is the topologically sorted circuit
+     * \return none
+     */
+    void StartPipeline(const Circuit &circuit);
+
+    /**
+     * \brief Hands the BDD of a gate to the pipeline if it is one of the pipelined outputs
+     * \param circuit is the topologically sorted circuit
+     * \param gate is the circuit ID of the gate
+     * \param root is the final BDD of the gate
+     * \return none
+     */
+    void PipelineOutput(const Circuit &circuit, unique_ID_t gate, ClassProject::BDD_ID root);
+
+    /**
+     * \brief Writes the structural hashes of printed outputs to HASH_FILE in the result directory
+     * \param hashes maps output labels to their hash, outputs with the unknown hash 0 are left out
+     * \return none
+     */
+    void WriteHashes(const std::map<label_t, uint64_t> &hashes);
+
+    /**
+     * \brief Collects all nodes not reachable from a BDD still held and renumbers the held BDDs
+     * \return none
+     */
+    void CollectGarbage();
+
+    /**
+     * \brief Returns the BDD_ID of the gate with the given label
      * \param label is label_t
+     * \return ClassProject::BDD_ID, NO_BDD if there is none
+     *
+     */
+    ClassProject::BDD_ID findBddIdByLabel(const label_t &label);
+
+    /**
+     * \brief Generates the BDD node equivalent to a variable with label "label".
+     * \param label is label_id_t
      * \return ClassProject::BDD_ID
      *
      */
-    ClassProject::BDD_ID InputGate(const label_t &label);
+    ClassProject::BDD_ID InputGate(label_id_t label);
 
     /**
      * \brief Generates the BDD node equivalent to the NOT gate.
-     * \param node is set_of_circuit_t containing the circuit ID of the gate to be inverted.
+     * \param node is id_range_t containing the circuit ID of the gate to be inverted.
+     * \return ClassProject::BDD_ID
+     *
+     */
+    ClassProject::BDD_ID NotGate(id_range_t node);
+
+    typedef ClassProject::BDD_ID (ClassProject::ManagerInterface::*binary_operation_t)(ClassProject::BDD_ID,
+                                                                                         ClassProject::BDD_ID);
+
+    /**
+     * \brief Returns the number of nodes of a BDD, including the terminals.
+     * \param root is ClassProject::BDD_ID
+     * \return size_t
+     *
+     */
+    size_t BddSize(ClassProject::BDD_ID root);
+
+    /**
+     * \brief Combines all inputs of a gate with an associative operation.
+     * \param inputNodes is id_range_t containing the circuit IDs of the gates to be used as input.
+     * \param operation is the two-input operation of the manager, e.g. and2
      * \return ClassProject::BDD_ID
      *
+     *  Gates with more than two inputs are reduced through a priority queue that always
+     *   combines the two smallest operand BDDs.
      */
-    ClassProject::BDD_ID NotGate(const set_of_circuit_t &node);
+    ClassProject::BDD_ID ReduceGate(id_range_t inputNodes, binary_operation_t operation);
 
     /**
      * \brief Generates the BDD node equivalent to the AND gate.
-     * \param node is set_of_circuit_t containing the circuit IDs of the gates to be used as input.
+     * \param node is id_range_t containing the circuit IDs of the gates to be used as input.
      * \return ClassProject::BDD_ID
      *
      */
-    ClassProject::BDD_ID AndGate(set_of_circuit_t inputNodes);
+    ClassProject::BDD_ID AndGate(id_range_t inputNodes);
 
     /**
      * \brief Generates the BDD node equivalent to the OR gate.
-     * \param node is set_of_circuit_t containing the circuit IDs of the gates to be used as input.
+     * \param node is id_range_t containing the circuit IDs of the gates to be used as input.
      * \return ClassProject::BDD_ID
      *
      */
-    ClassProject::BDD_ID OrGate(set_of_circuit_t inputNodes);
+    ClassProject::BDD_ID OrGate(id_range_t inputNodes);
 
     /**
      * \brief Generates the BDD node equivalent to the NAND gate.
-     * \param node is set_of_circuit_t containing the circuit IDs of the gates to be used as input.
+     * \param node is id_range_t containing the circuit IDs of the gates to be used as input.
      * \return ClassProject::BDD_ID
      *
      */
-    ClassProject::BDD_ID NandGate(set_of_circuit_t inputNodes);
+    ClassProject::BDD_ID NandGate(id_range_t inputNodes);
 
     /**
      * \brief Generates the BDD node equivalent to the NOR gate.
-     * \param node is set_of_circuit_t containing the circuit IDs of the gates to be used as input.
+     * \param node is id_range_t containing the circuit IDs of the gates to be used as input.
      * \return ClassProject::BDD_ID
      *
      */
-    ClassProject::BDD_ID NorGate(set_of_circuit_t inputNodes);
+    ClassProject::BDD_ID NorGate(id_range_t inputNodes);
 
     /**
      * \brief Generates the BDD node equivalent to the XOR gate.
-     * \param node is set_of_circuit_t containing the circuit IDs of the gates to be used as input.
+     * \param node is id_range_t containing the circuit IDs of the gates to be used as input.
      * \return ClassProject::BDD_ID
      *
      */
-    ClassProject::BDD_ID XorGate(set_of_circuit_t inputNodes);
-
-    void dumpBddText(std::ostream &out);
-
-    void dumpBddDot(std::ostream &out);
+    ClassProject::BDD_ID XorGate(id_range_t inputNodes);
 };   
@@ -0,0 +1,174 @@
+#ifndef VDSPROJECT_BENCH_TESTS_H
+#define VDSPROJECT_BENCH_TESTS_H
+
+#include <gtest/gtest.h>
+#include "BenchEquivalence.hpp"
+#include "BenchParser.hpp"
+#include "CircuitStrash.hpp"
+
+#include <filesystem>
+#include <fstream>
+#include <unistd.h>
+
+// Bench files go to a scratch directory that is removed after every test
+struct BenchTest : testing::Test {
+    std::filesystem::path scratch = std::filesystem::temp_directory_path() /
+                                    ("vdsproject_bench_" + std::to_string(::getpid()));
+
+    void SetUp() override {
+        std::filesystem::create_directories(scratch);
+    }
+
+    void TearDown() override {
+        std::filesystem::remove_all(scratch);
+    }
+
+    std::string writeBench(const std::string &name, const std::string &netlist) const {
+        std::filesystem::path path = scratch / (name + ".bench");
+        std::ofstream file(path);
+        file << netlist;
+        return path.string();
+    }
+};
+
+// c17 as in benchmarks/iscas85
+const std::string c17 = "INPUT(1)\nINPUT(2)\nINPUT(3)\nINPUT(6)\nINPUT(7)\n"
+                        "OUTPUT(22)\nOUTPUT(23)\n"
+                        "10 = NAND(1, 3)\n11 = NAND(3, 6)\n16 = NAND(2, 11)\n19 = NAND(11, 7)\n"
+                        "22 = NAND(10, 16)\n23 = NAND(16, 19)\n";
+
+// c17 with every NAND rewritten as OR of NOTs, so no gate but the inputs is structurally shared
+const std::string c17DeMorgan = "INPUT(1)\nINPUT(2)\nINPUT(3)\nINPUT(6)\nINPUT(7)\n"
+                                "OUTPUT(22)\nOUTPUT(23)\n"
+                                "n1 = NOT(1)\nn3 = NOT(3)\nn6 = NOT(6)\nn2 = NOT(2)\nn7 = NOT(7)\n"
+                                "10 = OR(n1, n3)\n11 = OR(n3, n6)\nn11 = NOT(11)\n16 = OR(n2, n11)\n"
+                                "19 = OR(n11, n7)\nn10 = NOT(10)\nn16 = NOT(16)\nn19 = NOT(19)\n"
+                                "22 = OR(n10, n16)\n23 = OR(n16, n19)\n";
+
+static equivalence_result_t checkEquivalence(const std::string &first, const std::string &second) {
+    BenchParser first_circuit(first);
+    BenchParser second_circuit(second);
+    BenchEquivalence equivalence(first_circuit, second_circuit);
+    return equivalence.Check();
+}
+
+TEST_F(BenchTest, Equivalence_RestructuredNetlistsAreEquivalent) /* NOLINT */
+{
+    equivalence_result_t result = checkEquivalence(writeBench("c17", c17), writeBench("c17_dm", c17DeMorgan));
+    EXPECT_EQ(result.equivalent, (std::vector<label_t>{"22", "23"}));
+    EXPECT_TRUE(result.different.empty());
+    EXPECT_TRUE(result.missing.empty());
+    EXPECT_GT(result.cut_points, 0u) << "Gates of both netlists computing the same function are cut.";
+    EXPECT_FALSE(std::filesystem::exists("results_c17_dm")) << "A check writes no results directory.";
+}
+
+TEST_F(BenchTest, Equivalence_SingleGateMutationIsFound) /* NOLINT */
+{
+    std::string mutated = c17DeMorgan;
+    mutated.replace(mutated.find("19 = OR"), 7, "19 = AND");
+    equivalence_result_t result = checkEquivalence(writeBench("c17", c17), writeBench("c17_mut", mutated));
+    EXPECT_EQ(result.equivalent, (std::vector<label_t>{"22"}));
+    EXPECT_EQ(result.different, (std::vector<label_t>{"23"}));
+    EXPECT_TRUE(result.missing.empty());
+}
+
+TEST_F(BenchTest, Equivalence_OutputsOfOneSideAreMissing) /* NOLINT */
+{
+    std::string extended = c17 + "OUTPUT(24)\n24 = AND(10, 19)\n";
+    equivalence_result_t result = checkEquivalence(writeBench("c17", c17), writeBench("c17_ext", extended));
+    EXPECT_EQ(result.equivalent, (std::vector<label_t>{"22", "23"}));
+    EXPECT_TRUE(result.different.empty());
+    EXPECT_EQ(result.missing, (std::vector<label_t>{"24"}));
+}
+
+// The BDDs of both circuits' outputs in one manager, with the INPUT gates of the same label sharing a variable
+static void expectSameOutputs(const Circuit &original, const Circuit &strashed) {
+    auto manager = std::make_shared<ClassProject::Manager>();
+    std::unordered_map<label_t, ClassProject::BDD_ID> bindings;
+    for (const auto &node : original.GetNodes()) {
+        if (node.gate_type == gate_type_t::INPUT) {
+            bindings[original.GetLabel(node.id)] = manager->createVar(original.GetLabel(node.id));
+        }
+    }
+
+    CircuitToBDD original_bdds(manager), strashed_bdds(manager);
+    original_bdds.SetInputVariables(bindings);
+    strashed_bdds.SetInputVariables(bindings);
+    original_bdds.BuildBDD(original);
+    strashed_bdds.BuildBDD(strashed);
+    ASSERT_EQ(original.GetRoots().size(), strashed.GetRoots().size());
+    for (const auto root : original.GetRoots()) {
+        const label_t &label = original.GetLabel(root);
+        EXPECT_EQ(strashed_bdds.GetBddId(label), original_bdds.GetBddId(label)) << "Output " << label << " changed.";
+    }
+}
+
+static const circuit_node_t &gateOf(const Circuit &circuit, const label_t &label) {
+    return circuit.GetNodes().at(circuit.FindGate(label));
+}
+
+TEST_F(BenchTest, Strash_FoldsComplementaryInputsToConstants) /* NOLINT */
+{
+    BenchParser parsed(writeBench("fold", "INPUT(a)\nINPUT(b)\nOUTPUT(o1)\nOUTPUT(o2)\nOUTPUT(o3)\n"
+                                          "na = NOT(a)\no1 = AND(a, na)\no2 = XOR(a, a)\no3 = OR(b, na, a)\n"));
+    CircuitStrash strash(parsed.GetSortedCircuit());
+    const Circuit &circuit = strash.GetCircuit();
+
+    EXPECT_EQ(gateOf(circuit, "o1").gate_type, gate_type_t::CONST0);
+    EXPECT_EQ(gateOf(circuit, "o2").gate_type, gate_type_t::CONST0);
+    expectSameOutputs(parsed.GetSortedCircuit(), circuit);
+}
+
+TEST_F(BenchTest, Strash_CollapsesNotChains) /* NOLINT */
+{
+    BenchParser parsed(writeBench("chain", "INPUT(a)\nOUTPUT(even)\nOUTPUT(odd)\n"
+                                           "n1 = NOT(a)\nn2 = NOT(n1)\nn3 = NOT(n2)\neven = NOT(n3)\nodd = NOT(n2)\n"));
+    CircuitStrash strash(parsed.GetSortedCircuit());
+    const Circuit &circuit = strash.GetCircuit();
+    unique_ID_t input = circuit.FindGate("a");
+
+    // Both outputs lost their own gate, a BUFF or NOT of the input carries the label
+    const circuit_node_t &even = gateOf(circuit, "even");
+    EXPECT_EQ(even.gate_type, gate_type_t::BUFFER);
+    ASSERT_EQ(circuit.GetFanins(even.id).size(), 1u);
+    EXPECT_EQ(circuit.GetFanins(even.id)[0], input);
+    const circuit_node_t &odd = gateOf(circuit, "odd");
+    EXPECT_EQ(odd.gate_type, gate_type_t::NOT);
+    ASSERT_EQ(circuit.GetFanins(odd.id).size(), 1u);
+    EXPECT_EQ(circuit.GetFanins(odd.id)[0], input);
+    expectSameOutputs(parsed.GetSortedCircuit(), circuit);
+}
+
+TEST_F(BenchTest, Strash_MergesDuplicateGates) /* NOLINT */
+{
+    // g1 and g2 only cancel if they are merged into one gate
+    BenchParser parsed(writeBench("dup", "INPUT(a)\nINPUT(b)\nOUTPUT(o)\n"
+                                         "g1 = AND(a, b)\ng2 = AND(b, a)\no = XOR(g1, g2)\n"));
+    CircuitStrash strash(parsed.GetSortedCircuit());
+    EXPECT_EQ(gateOf(strash.GetCircuit(), "o").gate_type, gate_type_t::CONST0);
+    EXPECT_EQ(strash.GetRemovedGates(), 2u);
+    expectSameOutputs(parsed.GetSortedCircuit(), strash.GetCircuit());
+}
+
+TEST_F(BenchTest, Strash_KeepsLabelOfMergedOutput) /* NOLINT */
+{
+    // o and q are the same gate once g1 and g2 are merged, only one of them keeps its own gate
+    BenchParser parsed(writeBench("merged", "INPUT(a)\nINPUT(b)\nINPUT(c)\nOUTPUT(o)\nOUTPUT(p)\n"
+                                            "g1 = AND(a, b)\ng2 = AND(b, a)\no = OR(g1, c)\nq = OR(c, g2)\n"
+                                            "p = BUFF(q)\n"));
+    CircuitStrash strash(parsed.GetSortedCircuit());
+    const Circuit &circuit = strash.GetCircuit();
+
+    EXPECT_EQ(strash.GetRemovedGates(), 1u);
+    ASSERT_NE(circuit.FindGate("o"), NO_CIRCUIT);
+    ASSERT_NE(circuit.FindGate("p"), NO_CIRCUIT);
+    for (const auto &label : {"o", "p"}) {
+        const circuit_node_t &gate = gateOf(circuit, label);
+        EXPECT_EQ(gate.gate_type, gate_type_t::BUFFER) << label;
+        ASSERT_EQ(circuit.GetFanins(gate.id).size(), 1u);
+        EXPECT_EQ(gateOf(circuit, "q").id, circuit.GetFanins(gate.id)[0]) << label;
+    }
+    expectSameOutputs(parsed.GetSortedCircuit(), circuit);
+}
+
+#endif
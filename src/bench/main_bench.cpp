@@ -4,43 +4,395 @@
 //
 
 #include <iostream>
+#include <sstream>
 #include <string>
 
 #include "Manager.h"
+#include "Trace.h"
 #include "BenchParser.hpp"
+#include "CircuitSimulator.hpp"
+#include "CircuitStrash.hpp"
 #include "CircuitToBDD.hpp"
+#include "BenchReachability.hpp"
+#include "BenchEquivalence.hpp"
+#include "BenchSuite.hpp"
 #include "BenchmarkLib.h"
 
+static void printUsage() {
+    std::cout << "Usage: benchmark_tool [--gc] [--strash] [--simulate W] [--outputs a,b,c] [--threads N] [--combined | --pipeline] [--format F] [--counters] [--trace F] <file.bench>" << std::endl;
+    std::cout << "       benchmark_tool --reach [--threads N] [--counters] [--trace F] <file.bench>" << std::endl;
+    std::cout << "       benchmark_tool --equiv <other.bench> [--simulate W] [--counters] [--trace F] <file.bench>" << std::endl;
+    std::cout << "       benchmark_tool --suite <dir> [--warmup N] [--repeat N] [--timeout S] [--json F] [--csv F] [--baseline F] [--threshold P] [--gc] [--threads N] [--format F] [--counters]" << std::endl;
+    std::cout << "  --gc           garbage collect released gate BDDs while building" << std::endl;
+    std::cout << "  --strash       merge duplicate gates and propagate constants before building" << std::endl;
+    std::cout << "  --simulate W   check the output BDDs against 64 * W random patterns" << std::endl;
+    std::cout << "  --outputs L    build and print only the cone of influence of the comma separated labels" << std::endl;
+    std::cout << "  --reach        reachable state space of a sequential (ISCAS89) circuit" << std::endl;
+    std::cout << "  --threads N    threads building and printing the outputs, or for the image computation in --reach mode" << std::endl;
+    std::cout << "  --combined     print all outputs into one file per format" << std::endl;
+    std::cout << "  --pipeline     print every output while the remaining ones are still built" << std::endl;
+    std::cout << "  --format F     comma separated formats to print, text, dot and binary (default text,dot)" << std::endl;
+    std::cout << "  --equiv F      check the outputs of the circuit and of F for equivalence" << std::endl;
+    std::cout << "  --suite D      parse, build and dump every bench file of D (e.g. benchmarks/iscas85)" << std::endl;
+    std::cout << "  --warmup N     unmeasured runs per circuit before the measured ones (default 1)" << std::endl;
+    std::cout << "  --repeat N     measured runs per circuit (default 3)" << std::endl;
+    std::cout << "  --timeout S    stop a run after S seconds (default no limit)" << std::endl;
+    std::cout << "  --json F       write the suite results as JSON to F" << std::endl;
+    std::cout << "  --csv F        write the suite results as CSV to F, one row per run" << std::endl;
+    std::cout << "  --baseline F   compare the suite results with the CSV F of an earlier suite" << std::endl;
+    std::cout << "  --threshold P  percent of growth in time or peak RSS counted as regression (default 10)" << std::endl;
+    std::cout << "  --counters     report hardware performance counters of every phase, if the system allows them" << std::endl;
+    std::cout << "  --trace F      write a timeline of the parse, build, print and GC phases to F, for chrome://tracing or Perfetto" << std::endl;
+}
+
+/* Set by --counters if at least one hardware counter could be opened */
+static bool report_counters = false;
+
+/* Set by --trace, the timeline is written when the run ends */
+static std::string trace_file;
+
+static int finishTrace(int status) {
+    if (!trace_file.empty() && !ClassProject::Trace::write(trace_file)) {
+        std::cout << "- Unable to write the trace to " << trace_file << std::endl;
+    }
+    return status;
+}
+
+static void printCounters(const std::string &phase, const hw_counters_t &counters) {
+    if (!report_counters) return;
+    std::cout << " " << phase << " counters: ";
+    write_hw_counters(std::cout, counters);
+    std::cout << std::endl;
+}
+
+static int runReachability(const std::string &bench_file, unsigned int threads) {
+    double parse_time, build_time, reach_time, vm1, rss1, vm2, rss2;
+
+    hw_counters_t parse_counters, build_counters, reach_counters;
+
+    process_mem_usage(vm1, rss1);
+
+    parse_time = wallTime();
+    parse_counters = read_hw_counters();
+    BenchParser parsed_circuit(bench_file);
+    parse_counters = hw_counters_delta(parse_counters, read_hw_counters());
+    parse_time = wallTime() - parse_time;
+
+    std::cout << "- Building transition functions...";
+    build_time = wallTime();
+    build_counters = read_hw_counters();
+    BenchReachability reachability(parsed_circuit, bench_file, threads);
+    build_counters = hw_counters_delta(build_counters, read_hw_counters());
+    build_time = wallTime() - build_time;
+    std::cout << " Done!" << std::endl;
+
+    std::cout << "- Computing reachable states...";
+    reach_time = wallTime();
+    reach_counters = read_hw_counters();
+    auto result = reachability.ComputeReachableStates();
+    reach_counters = hw_counters_delta(reach_counters, read_hw_counters());
+    reach_time = wallTime() - reach_time;
+    std::cout << " Done!" << std::endl << std::endl;
+
+    auto fsm = reachability.GetStateMachine();
+    std::set<ClassProject::BDD_ID> reachable_nodes;
+    fsm->findNodes(result.reachable, reachable_nodes);
+
+    std::cout << "**** Reachability ****" << std::endl;
+    std::cout << " State bits: " << fsm->getStates().size() << "; Inputs: " << fsm->getInputs().size() << std::endl;
+    std::cout << " Reachable states: " << fsm->countStates(result.reachable) << std::endl;
+    std::cout << " Sequential depth: " << result.depth << std::endl;
+    std::cout << " Reachable set BDD nodes: " << reachable_nodes.size() << std::endl << std::endl;
+
+    std::cout << "**** Performance ****" << std::endl;
+    std::cout << " Image threads: " << threads << std::endl;
+    std::cout << " Parse time: " << parse_time << std::endl;
+    std::cout << " Build time: " << build_time << std::endl;
+    std::cout << " Fixpoint time: " << reach_time << std::endl;
+    printCounters("Parse", parse_counters);
+    printCounters("Build", build_counters);
+    printCounters("Fixpoint", reach_counters);
+    std::cout << " Unique table size: " << fsm->uniqueTableSize() << std::endl;
+    process_mem_usage(vm2, rss2);
+    std::cout << " VM: " << vm2 - vm1 << "; RSS: " << rss2 - rss1 << endl << endl;
+
+    return 0;
+}
+
+static void printLabels(const std::string &title, const std::vector<label_t> &labels) {
+    if (labels.empty()) return;
+    std::cout << " " << title << ":";
+    for (const auto &label : labels) {
+        std::cout << " " << label;
+    }
+    std::cout << std::endl;
+}
+
+static int runSuite(const std::string &directory, const suite_options_t &options, const std::string &json_file,
+                    const std::string &csv_file, const std::string &baseline_file, double threshold) {
+    BenchSuite suite(directory, options);
+    suite.Run();
+    if (!json_file.empty()) {
+        suite.WriteJson(json_file);
+    }
+    if (!csv_file.empty()) {
+        suite.WriteCsv(csv_file);
+    }
+    if (!baseline_file.empty() && suite.CompareBaseline(baseline_file, threshold / 100) > 0) {
+        return 1;
+    }
+    return 0;
+}
+
+static int runEquivalence(const std::string &bench_file, const std::string &other_file, size_t simulation_words) {
+    double user_time, vm1, rss1, vm2, rss2;
+
+    BenchParser parsed_circuit(bench_file);
+    BenchParser other_circuit(other_file);
+
+    std::cout << "- Checking equivalence...";
+    process_mem_usage(vm1, rss1);
+    user_time = userTime();
+    hw_counters_t counters = read_hw_counters();
+    BenchEquivalence equivalence(parsed_circuit, other_circuit, simulation_words);
+    auto result = equivalence.Check();
+    counters = hw_counters_delta(counters, read_hw_counters());
+    user_time = userTime() - user_time;
+    std::cout << " Done!" << std::endl << std::endl;
+
+    std::cout << "**** Equivalence ****" << std::endl;
+    std::cout << " Equivalent outputs: " << result.equivalent.size() << "; Different outputs: "
+              << result.different.size() << "; Missing outputs: " << result.missing.size() << std::endl;
+    printLabels("Different", result.different);
+    printLabels("Missing", result.missing);
+    std::cout << " Cut points: " << result.cut_points << std::endl << std::endl;
+
+    std::cout << "**** Performance ****" << std::endl;
+    std::cout << " Runtime: " << user_time << std::endl;
+    printCounters("Check", counters);
+    std::cout << " Unique table size: " << equivalence.GetManager()->uniqueTableSize() << std::endl;
+    process_mem_usage(vm2, rss2);
+    std::cout << " VM: " << vm2 - vm1 << "; RSS: " << rss2 - rss1 << endl << endl;
+
+    return (result.different.empty() && result.missing.empty()) ? 0 : 1;
+}
+
 int main(int argc, char *argv[]) {
 
-    if (2 > argc) {
+    std::string bench_file;
+    bool reach_mode = false;
+    bool gc = false;
+    bool strash = false;
+    size_t simulation_words = 0;
+    std::set<label_t> selected_outputs;
+    std::string equiv_file;
+    unsigned int threads = 1;
+    bool combined = false;
+    bool pipelined = false;
+    unsigned int formats = TEXT_FORMAT | DOT_FORMAT;
+    std::string suite_dir;
+    suite_options_t suite_options;
+    std::string json_file, csv_file, baseline_file;
+    double threshold = 10;
+    bool counters = false;
+
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--reach") {
+            reach_mode = true;
+        } else if (arg == "--gc") {
+            gc = true;
+        } else if (arg == "--strash") {
+            strash = true;
+        } else if (arg == "--combined") {
+            combined = true;
+        } else if (arg == "--pipeline") {
+            pipelined = true;
+        } else if (arg == "--counters") {
+            counters = true;
+        } else if (arg == "--format" && i + 1 < argc) {
+            std::stringstream names(argv[++i]);
+            std::string name;
+            formats = 0;
+            while (std::getline(names, name, ',')) {
+                if (name == "text") {
+                    formats |= TEXT_FORMAT;
+                } else if (name == "dot") {
+                    formats |= DOT_FORMAT;
+                } else if (name == "binary") {
+                    formats |= BINARY_FORMAT;
+                } else {
+                    printUsage();
+                    return -1;
+                }
+            }
+        } else if (arg == "--outputs" && i + 1 < argc) {
+            std::stringstream labels(argv[++i]);
+            std::string label;
+            while (std::getline(labels, label, ',')) {
+                if (!label.empty()) selected_outputs.insert(label);
+            }
+        } else if (arg == "--equiv" && i + 1 < argc) {
+            equiv_file = argv[++i];
+        } else if (arg == "--simulate" && i + 1 < argc) {
+            simulation_words = std::stoul(argv[++i]);
+        } else if (arg == "--threads" && i + 1 < argc) {
+            threads = std::stoul(argv[++i]);
+        } else if (arg == "--suite" && i + 1 < argc) {
+            suite_dir = argv[++i];
+        } else if (arg == "--warmup" && i + 1 < argc) {
+            suite_options.warmup = std::stoul(argv[++i]);
+        } else if (arg == "--repeat" && i + 1 < argc) {
+            suite_options.repetitions = std::stoul(argv[++i]);
+        } else if (arg == "--timeout" && i + 1 < argc) {
+            suite_options.timeout = std::stoul(argv[++i]);
+        } else if (arg == "--json" && i + 1 < argc) {
+            json_file = argv[++i];
+        } else if (arg == "--csv" && i + 1 < argc) {
+            csv_file = argv[++i];
+        } else if (arg == "--baseline" && i + 1 < argc) {
+            baseline_file = argv[++i];
+        } else if (arg == "--threshold" && i + 1 < argc) {
+            threshold = std::stod(argv[++i]);
+        } else if (arg == "--trace" && i + 1 < argc) {
+            trace_file = argv[++i];
+        } else if (arg.rfind("--", 0) == 0) {
+            printUsage();
+            return -1;
+        } else {
+            bench_file = arg;
+        }
+    }
+
+    if (counters && !suite_dir.empty()) {
+        suite_options.counters = true;
+    } else if (counters) {
+        report_counters = open_hw_counters();
+        if (!report_counters) {
+            std::cout << "- Hardware counters are not available, reporting timings only" << std::endl;
+        }
+    }
+
+    /* Suite runs happen in child processes, a timeline of the parent would be empty */
+    if (!trace_file.empty() && !suite_dir.empty()) {
+        std::cout << "- Tracing is not supported in --suite mode, trace a single circuit instead" << std::endl;
+        trace_file.clear();
+    } else if (!trace_file.empty()) {
+        ClassProject::Trace::enable();
+    }
+
+    if (!suite_dir.empty()) {
+        suite_options.threads = threads;
+        suite_options.gc = gc;
+        suite_options.formats = formats;
+        return runSuite(suite_dir, suite_options, json_file, csv_file, baseline_file, threshold);
+    }
+
+    if (bench_file.empty()) {
         std::cout << "Must specify a filename!" << std::endl;
+        printUsage();
+        return -1;
+    }
+
+    if (combined && pipelined) {
+        std::cout << "A combined print needs all outputs, it cannot be pipelined!" << std::endl;
+        printUsage();
         return -1;
     }
 
-    std::string bench_file = argv[1];
+    if (reach_mode) {
+        return finishTrace(runReachability(bench_file, threads));
+    }
+
+    if (!equiv_file.empty()) {
+        return finishTrace(runEquivalence(bench_file, equiv_file, (simulation_words > 0) ? simulation_words : 16));
+    }
 
     /* Parse the circuit from file and generate topological sorted circuit */
+    double parse_time = wallTime();
+    hw_counters_t parse_counters = read_hw_counters();
     BenchParser parsed_circuit(bench_file);
+    parse_counters = hw_counters_delta(parse_counters, read_hw_counters());
+    parse_time = wallTime() - parse_time;
+
+    std::unique_ptr<CircuitStrash> strashed_circuit;
+    if (strash) {
+        std::cout << "- Strashing the circuit...";
+        strashed_circuit = make_unique<CircuitStrash>(parsed_circuit.GetSortedCircuit());
+        std::cout << " Done! Removed " << strashed_circuit->GetRemovedGates() << " gates" << std::endl;
+    }
+    const Circuit &circuit = strash ? strashed_circuit->GetCircuit() : parsed_circuit.GetSortedCircuit();
 
     auto BDD_manager = make_shared<ClassProject::Manager>();
     auto circuit2BDD = make_unique<CircuitToBDD>(BDD_manager);
+    if (gc) {
+        circuit2BDD->EnableGarbageCollection(1 << 20);
+    }
+    circuit2BDD->SetSelectedOutputs(selected_outputs);
+    const std::set<label_t> &output_labels = selected_outputs.empty() ? parsed_circuit.GetListOfOutputLabels()
+                                                                      : selected_outputs;
+    if (pipelined) {
+        circuit2BDD->SetPipelinedPrint(output_labels, formats);
+    }
 
-    double user_time, vm1, rss1, vm2, rss2;
+    double user_time, wall_time, print_time, vm1, rss1, vm2, rss2;
 
     std::cout << "- Generating BDD from circuit...";
     process_mem_usage(vm1, rss1);
     user_time = userTime();
-    circuit2BDD->GenerateBDD(parsed_circuit.GetSortedCircuit(), bench_file);
+    wall_time = wallTime();
+    hw_counters_t build_counters = read_hw_counters();
+    if (threads > 1) {
+        circuit2BDD->GenerateBDDParallel(circuit, bench_file, threads);
+    } else {
+        circuit2BDD->GenerateBDD(circuit, bench_file);
+    }
+    build_counters = hw_counters_delta(build_counters, read_hw_counters());
     user_time = userTime() - user_time;
+    wall_time = wallTime() - wall_time;
     std::cout << " BDD generated successfully!" << std::endl << std::endl;
 
-    circuit2BDD->PrintBDD(parsed_circuit.GetListOfOutputLabels());
+    /* A pipelined print only waits for the outputs the writer has not caught up with */
+    print_time = wallTime();
+    hw_counters_t print_counters = read_hw_counters();
+    if (pipelined) {
+        circuit2BDD->FinishPrint();
+    } else {
+        circuit2BDD->PrintBDD(output_labels, threads, combined, formats);
+    }
+    print_counters = hw_counters_delta(print_counters, read_hw_counters());
+    print_time = wallTime() - print_time;
+
+    size_t mismatches = 0;
+    if (simulation_words > 0) {
+        std::cout << "- Checking the BDDs against simulation...";
+        CircuitSimulator simulator(circuit, simulation_words);
+        for (const auto &label : output_labels) {
+            if (!simulator.MatchesBdd(*BDD_manager, circuit2BDD->GetBddId(label), circuit.FindGate(label))) {
+                std::cout << std::endl << "  Output " << label << " differs from simulation!";
+                mismatches++;
+            }
+        }
+        std::cout << " Done!" << std::endl;
+        std::cout << " Patterns: " << simulator.GetPatternCount() << "; Mismatching outputs: " << mismatches
+                  << "; Candidate equivalence classes: " << simulator.GetEquivalenceCandidates().size()
+                  << std::endl << std::endl;
+    }
 
     std::cout << "**** Performance ****" << std::endl;
+    std::cout << " Parse time: " << parse_time << std::endl;
     std::cout << " Runtime: " << user_time << std::endl;
+    std::cout << " Wall time: " << wall_time << std::endl;
+    std::cout << " Print time: " << print_time << std::endl;
+    printCounters("Parse", parse_counters);
+    printCounters("Build", build_counters);
+    printCounters("Print", print_counters);
+    if (gc) {
+        std::cout << " Garbage collections: " << circuit2BDD->GetGarbageCollectionRuns()
+                  << "; Freed nodes: " << circuit2BDD->GetFreedNodes() << std::endl;
+    }
     process_mem_usage(vm2, rss2);
     std::cout << " VM: " << vm2 - vm1 << "; RSS: " << rss2 - rss1 << endl << endl;
 
-    return 0;
+    return finishTrace((mismatches == 0) ? 0 : 1);
 }
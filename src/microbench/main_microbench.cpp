@@ -0,0 +1,367 @@
+//
+// Microbenchmarks of the Manager kernel operations on standard BDD families
+//
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "Manager.h"
+
+using ClassProject::BDD_ID;
+using ClassProject::Manager;
+using ClassProject::ManagerStats;
+
+/* One timed section: the operations it ran and what they did to the manager */
+typedef struct measurement_t {
+    size_t ops = 0;
+    double seconds = 0;
+    size_t nodes = 0;       // nodes created
+    ManagerStats stats;
+} measurement_t;
+
+typedef struct microbenchmark_t {
+    std::string name;
+    std::vector<size_t> sizes;                 // problem sizes of the sweep
+    std::function<measurement_t(size_t)> run;  // sets up a fresh manager and times one repetition
+} microbenchmark_t;
+
+/* Times body, which returns the number of operations it ran */
+static measurement_t Measure(Manager &manager, const std::function<size_t()> &body) {
+    measurement_t result;
+    size_t nodes_before = manager.uniqueTableSize();
+    manager.resetStats();
+    auto start = std::chrono::steady_clock::now();
+    result.ops = body();
+    result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    result.stats = manager.stats();
+    result.nodes = manager.uniqueTableSize() - nodes_before;
+    return result;
+}
+
+/* Operand bits interleaved with the most significant bits on top, the order that keeps adders linear.
+ * a[i] and b[i] are bit i */
+static void CreateOperands(Manager &manager, size_t bits, std::vector<BDD_ID> &a, std::vector<BDD_ID> &b) {
+    a.resize(bits);
+    b.resize(bits);
+    for (size_t i = bits; i-- > 0;) {
+        a[i] = manager.createVar("a" + std::to_string(i));
+        b[i] = manager.createVar("b" + std::to_string(i));
+    }
+}
+
+/* Ripple carry adder, returns the sum bits and the carry out. Counts 5 operations per bit */
+static std::vector<BDD_ID> Adder(Manager &manager, const std::vector<BDD_ID> &a, const std::vector<BDD_ID> &b,
+                                 size_t &ops) {
+    std::vector<BDD_ID> sum;
+    BDD_ID carry = manager.False();
+    for (size_t i = 0; i < a.size(); i++) {
+        BDD_ID half = manager.xor2(a[i], b[i]);
+        sum.push_back(manager.xor2(half, carry));
+        carry = manager.or2(manager.and2(a[i], b[i]), manager.and2(half, carry));
+        ops += 5;
+    }
+    sum.push_back(carry);
+    return sum;
+}
+
+static measurement_t AdderFamily(size_t bits) {
+    Manager manager;
+    std::vector<BDD_ID> a, b;
+    CreateOperands(manager, bits, a, b);
+    return Measure(manager, [&]() {
+        size_t ops = 0;
+        Adder(manager, a, b, ops);
+        return ops;
+    });
+}
+
+/* Array multiplier, every partial product row is added with a ripple carry adder */
+static measurement_t MultiplierFamily(size_t bits) {
+    Manager manager;
+    std::vector<BDD_ID> a, b;
+    CreateOperands(manager, bits, a, b);
+    return Measure(manager, [&]() {
+        size_t ops = 0;
+        std::vector<BDD_ID> product(2 * bits, manager.False());
+        for (size_t j = 0; j < bits; j++) {
+            std::vector<BDD_ID> row, window;
+            for (size_t i = 0; i < bits; i++) {
+                row.push_back(manager.and2(a[i], b[j]));
+                window.push_back(product[i + j]);
+                ops++;
+            }
+            std::vector<BDD_ID> sum = Adder(manager, window, row, ops);
+            for (size_t i = 0; i <= bits && i + j < product.size(); i++) {
+                product[i + j] = sum[i];
+            }
+        }
+        return ops;
+    });
+}
+
+/* n-queens: one queen per row, no two queens attacking each other */
+static measurement_t QueensFamily(size_t n) {
+    Manager manager;
+    std::vector<std::vector<BDD_ID>> cells(n);
+    for (size_t r = 0; r < n; r++) {
+        for (size_t c = 0; c < n; c++) {
+            cells[r].push_back(manager.createVar("x" + std::to_string(r) + "_" + std::to_string(c)));
+        }
+    }
+    return Measure(manager, [&]() {
+        size_t ops = 0;
+        BDD_ID board = manager.True();
+        for (size_t r = 0; r < n; r++) {
+            BDD_ID row = manager.False();
+            for (size_t c = 0; c < n; c++) {
+                row = manager.or2(row, cells[r][c]);
+                ops++;
+            }
+            board = manager.and2(board, row);
+            ops++;
+        }
+        for (size_t r = 0; r < n; r++) {
+            for (size_t c = 0; c < n; c++) {
+                BDD_ID free = manager.True();
+                for (size_t r2 = 0; r2 < n; r2++) {
+                    for (size_t c2 = 0; c2 < n; c2++) {
+                        bool same = r2 == r && c2 == c;
+                        bool attacks = r2 == r || c2 == c || r2 + c == r + c2 || r2 + c2 == r + c;
+                        if (!same && attacks) {
+                            free = manager.and2(free, manager.neg(cells[r2][c2]));
+                            ops += 2;
+                        }
+                    }
+                }
+                board = manager.and2(board, manager.or2(manager.neg(cells[r][c]), free));
+                ops += 3;
+            }
+        }
+        return ops;
+    });
+}
+
+static measurement_t ParityFamily(size_t n) {
+    Manager manager;
+    std::vector<BDD_ID> vars;
+    for (size_t i = 0; i < n; i++) {
+        vars.push_back(manager.createVar("x" + std::to_string(i)));
+    }
+    return Measure(manager, [&]() {
+        /* From the bottom of the order up, so every step only adds nodes on top */
+        BDD_ID parity = manager.False();
+        for (auto var = vars.rbegin(); var != vars.rend(); ++var) {
+            parity = manager.xor2(parity, *var);
+        }
+        return vars.size();
+    });
+}
+
+/* Disjunction of n random cubes of three literals over n variables, with a fixed seed */
+static measurement_t RandomFamily(size_t n) {
+    Manager manager;
+    std::vector<BDD_ID> vars;
+    for (size_t i = 0; i < n; i++) {
+        vars.push_back(manager.createVar("x" + std::to_string(i)));
+    }
+    std::mt19937_64 random(n);
+    return Measure(manager, [&]() {
+        size_t ops = 0;
+        BDD_ID function = manager.False();
+        for (size_t term = 0; term < n; term++) {
+            BDD_ID cube = manager.True();
+            for (int literal = 0; literal < 3; literal++) {
+                BDD_ID var = vars[random() % n];
+                cube = manager.and2(cube, (random() & 1) ? var : manager.neg(var));
+                ops += 2;
+            }
+            function = manager.or2(function, cube);
+            ops++;
+        }
+        return ops;
+    });
+}
+
+/* Sum and carry bits of an adder of the given width, the operands of the kernel benchmarks */
+static std::vector<BDD_ID> AdderPool(Manager &manager, size_t bits) {
+    std::vector<BDD_ID> a, b;
+    CreateOperands(manager, bits, a, b);
+    size_t ops = 0;
+    return Adder(manager, a, b, ops);
+}
+
+static measurement_t BinaryKernel(size_t bits, BDD_ID (Manager::*operation)(BDD_ID, BDD_ID)) {
+    Manager manager;
+    std::vector<BDD_ID> pool = AdderPool(manager, bits);
+    return Measure(manager, [&]() {
+        size_t ops = 0;
+        for (size_t i = 0; i < pool.size(); i++) {
+            for (size_t j = i + 1; j < pool.size(); j++) {
+                (manager.*operation)(pool[i], pool[j]);
+                ops++;
+            }
+        }
+        return ops;
+    });
+}
+
+static measurement_t IteKernel(size_t bits) {
+    Manager manager;
+    std::vector<BDD_ID> pool = AdderPool(manager, bits);
+    return Measure(manager, [&]() {
+        size_t ops = 0;
+        for (size_t i = 0; i < pool.size(); i++) {
+            for (size_t j = 0; j < pool.size(); j++) {
+                manager.ite(pool[i], pool[j], pool[(i + j + 1) % pool.size()]);
+                ops++;
+            }
+        }
+        return ops;
+    });
+}
+
+static measurement_t CoFactorKernel(size_t bits) {
+    Manager manager;
+    std::vector<BDD_ID> pool = AdderPool(manager, bits);
+    return Measure(manager, [&]() {
+        size_t ops = 0;
+        for (const auto f : pool) {
+            for (BDD_ID var = 2; var < 2 + 2 * bits; var++) {
+                manager.coFactorTrue(f, var);
+                ops++;
+            }
+        }
+        return ops;
+    });
+}
+
+static measurement_t FindNodesKernel(size_t bits) {
+    Manager manager;
+    std::vector<BDD_ID> pool = AdderPool(manager, bits);
+    return Measure(manager, [&]() {
+        for (const auto f : pool) {
+            std::set<BDD_ID> nodes;
+            manager.findNodes(f, nodes);
+        }
+        return pool.size();
+    });
+}
+
+static measurement_t UniqueTableSizeKernel(size_t calls) {
+    Manager manager;
+    AdderPool(manager, 8);
+    return Measure(manager, [&]() {
+        size_t sum = 0;
+        for (size_t i = 0; i < calls; i++) {
+            sum += manager.uniqueTableSize();
+        }
+        /* Keeps the loop from being optimized away */
+        volatile size_t sink = sum;
+        (void) sink;
+        return calls;
+    });
+}
+
+static double Ratio(size_t part, size_t whole) {
+    return (whole == 0) ? 0 : 100.0 * part / whole;
+}
+
+static void printUsage() {
+    std::cout << "Usage: microbench [--filter S] [--min-time T] [--csv F]" << std::endl;
+    std::cout << "  --filter S     run only the benchmarks whose name contains S" << std::endl;
+    std::cout << "  --min-time T   repeat every size for at least T seconds (default 0.2)" << std::endl;
+    std::cout << "  --csv F        also write the results as CSV to F" << std::endl;
+}
+
+int main(int argc, char *argv[]) {
+    std::string filter, csv_file;
+    double min_time = 0.2;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--filter" && i + 1 < argc) {
+            filter = argv[++i];
+        } else if (arg == "--min-time" && i + 1 < argc) {
+            min_time = std::stod(argv[++i]);
+        } else if (arg == "--csv" && i + 1 < argc) {
+            csv_file = argv[++i];
+        } else {
+            printUsage();
+            return -1;
+        }
+    }
+
+    std::vector<microbenchmark_t> benchmarks = {
+            {"adder",            {8, 16, 32, 64, 128},     AdderFamily},
+            {"multiplier",       {4, 6, 8},                MultiplierFamily},
+            {"queens",           {4, 5, 6, 7},             QueensFamily},
+            {"parity",           {256, 1024, 4096, 16384},    ParityFamily},
+            {"random",           {8, 16, 24, 32},          RandomFamily},
+            {"and2",             {8, 12, 16},              [](size_t n) { return BinaryKernel(n, &Manager::and2); }},
+            {"xor2",             {8, 12, 16},              [](size_t n) { return BinaryKernel(n, &Manager::xor2); }},
+            {"ite",              {8, 12, 16},              IteKernel},
+            {"coFactorTrue",     {8, 12, 16},              CoFactorKernel},
+            {"findNodes",        {8, 12, 16},              FindNodesKernel},
+            {"uniqueTableSize",  {1000000},                UniqueTableSizeKernel},
+    };
+
+    std::ofstream csv;
+    if (!csv_file.empty()) {
+        csv.open(csv_file);
+        if (!csv.is_open()) {
+            std::cout << "Unable to open " << csv_file << "!" << std::endl;
+            return -1;
+        }
+        csv << "benchmark,size,repetitions,ops,ns_per_op,nodes_per_sec,computed_hit_rate,unique_hit_rate,nodes"
+            << std::endl;
+    }
+
+    std::cout << std::left << std::setw(16) << "Benchmark" << std::right << std::setw(9) << "Size"
+              << std::setw(6) << "Reps" << std::setw(12) << "Ops" << std::setw(12) << "ns/op" << std::setw(14)
+              << "Nodes/s" << std::setw(11) << "Computed%" << std::setw(9) << "Unique%" << std::setw(12) << "Nodes"
+              << std::endl;
+
+    for (const auto &benchmark : benchmarks) {
+        if (benchmark.name.find(filter) == std::string::npos) continue;
+        for (const auto size : benchmark.sizes) {
+            /* Every repetition starts from a fresh manager, the counts are the same each time */
+            measurement_t total;
+            size_t repetitions = 0;
+            while (repetitions == 0 || total.seconds < min_time) {
+                measurement_t run = benchmark.run(size);
+                if (repetitions == 0) {
+                    total = run;
+                } else {
+                    total.seconds += run.seconds;
+                }
+                repetitions++;
+            }
+
+            double seconds = total.seconds / repetitions;
+            double ns_per_op = (total.ops == 0) ? 0 : 1e9 * seconds / total.ops;
+            double nodes_per_sec = (seconds == 0) ? 0 : total.nodes / seconds;
+            const ManagerStats &stats = total.stats;
+            double computed_rate = Ratio(stats.computedHits, stats.computedHits + stats.computedMisses);
+            double unique_rate = Ratio(stats.uniqueHits, stats.uniqueLookups);
+
+            std::cout << std::left << std::setw(16) << benchmark.name << std::right << std::setw(9) << size
+                      << std::setw(6) << repetitions << std::setw(12) << total.ops << std::fixed
+                      << std::setprecision(1) << std::setw(12) << ns_per_op << std::setprecision(0) << std::setw(14)
+                      << nodes_per_sec << std::setprecision(1) << std::setw(11) << computed_rate << std::setw(9)
+                      << unique_rate << std::setw(12) << total.nodes << std::defaultfloat << std::endl;
+            if (csv.is_open()) {
+                csv << benchmark.name << "," << size << "," << repetitions << "," << total.ops << "," << ns_per_op
+                    << "," << nodes_per_sec << "," << computed_rate << "," << unique_rate << "," << total.nodes
+                    << std::endl;
+            }
+        }
+    }
+    return 0;
+}
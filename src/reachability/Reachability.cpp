@@ -1,5 +1,10 @@
 #include "Reachability.h"
+#include "../Trace.h"
 #include <iostream>
+#include <set>
+#include <thread>
+#include <algorithm>
+#include <cmath>
 
 namespace ClassProject {
     Reachability::Reachability(unsigned int stateSize, unsigned int inputSize) : ReachabilityInterface(
@@ -8,16 +13,21 @@ namespace ClassProject {
             throw std::runtime_error("State size cannot be zero");
         }
 
-        // Create variables for currentState(s), nextState(s') and input(x)
+        // Create variables for currentState(s), nextState(s'), intermediateState(s'') and input(x)
+        // s, s' and s'' are interleaved, otherwise the renaming relations grow exponentially
         for (unsigned int i = 0; i < stateSize; i++) {
             currentStateVars.push_back(createVar("s" + std::to_string(i)));
             nextStateVars.push_back(createVar("s" + std::to_string(i) + "'"));
+            intermediateStateVars.push_back(createVar("s" + std::to_string(i) + "''"));
         }
 
         for (unsigned int i = 0; i < inputSize; i++) {
             inputVars.push_back(createVar("x" + std::to_string(i)));
         }
 
+        currentStateAndInputVars = currentStateVars;
+        currentStateAndInputVars.insert(currentStateAndInputVars.end(), inputVars.begin(), inputVars.end());
+
         initialState = True(); // Characteristic function
         for (BDD_ID s: currentStateVars) {
             initialState = and2(initialState, neg(s));
@@ -29,6 +39,7 @@ namespace ClassProject {
         //  Performing Conjunction (AND) of XNORs; nxt state var should be same as output of current state
         for (BDD_ID i = 0; i < stateSize; i++) {
             BDD_ID equivalence = xnor2(currentStateVars[i], nextStateVars[i]);
+            transitionPartitions.push_back(equivalence);
             transitionRelation = and2(equivalence, transitionRelation);
         }
     }
@@ -47,14 +58,7 @@ namespace ClassProject {
         }
 
         // Initial state Characteristic function
-        initialState = True();
-        for (BDD_ID i = 0; i < currentStateVars.size(); i++) {
-            if (stateVector[i]) {
-                initialState = and2(initialState, currentStateVars[i]);
-            } else {
-                initialState = and2(initialState, neg(currentStateVars[i]));
-            }
-        }
+        initialState = stateCube(stateVector);
     }
 
     void Reachability::setTransitionFunctions(const std::vector<BDD_ID> &transitionFunctions) {
@@ -70,25 +74,387 @@ namespace ClassProject {
         }
 
         transitionRelation = True();
+        transitionPartitions.clear();
         //  Performing Conjunction (AND) of XNORs; nxt state var should be same as output of current state
         for (BDD_ID i = 0; i < currentStateVars.size(); i++) {
             BDD_ID equivalence = xnor2(transitionFunctions[i], nextStateVars[i]);
+            transitionPartitions.push_back(equivalence);
             transitionRelation = and2(equivalence, transitionRelation);
         }
+
+        // Worker managers hold copies of the old clusters
+        imageWorkers.clear();
     }
 
-    int Reachability::stateDistance(const std::vector<bool> &stateVector) {
-        if (stateVector.size() != currentStateVars.size()) {
-            throw std::runtime_error("Size mismatch");
+    void Reachability::setTraversalMode(TraversalMode mode) {
+        traversalMode = mode;
+    }
+
+    void Reachability::setSquaringThreshold(size_t maxFrontierNodes, unsigned int iterations) {
+        squaringFrontierLimit = maxFrontierNodes;
+        squaringSwitchIterations = iterations;
+    }
+
+    void Reachability::setFrontierSimplification(FrontierSimplification strategy) {
+        frontierSimplification = strategy;
+    }
+
+    void Reachability::setImageThreads(unsigned int threads) {
+        imageThreads = std::max(1u, threads);
+        imageWorkers.clear();
+    }
+
+    size_t Reachability::nodeCount(BDD_ID f) {
+        std::set<BDD_ID> nodesOfF;
+        findNodes(f, nodesOfF);
+        return nodesOfF.size();
+    }
+
+    BDD_ID Reachability::simplifyFrontier(BDD_ID frontier, BDD_ID visited) {
+        if (frontierSimplification == FrontierSimplification::None) {
+            return frontier;
+        }
+
+        // Images of visited states are visited again, so only 'visited AND NOT frontier' is don't care
+        BDD_ID careSet = or2(frontier, neg(visited));
+
+        switch (frontierSimplification) {
+            case FrontierSimplification::Restrict:
+                return restrict(frontier, careSet);
+            case FrontierSimplification::Constrain:
+                return constrain(frontier, careSet);
+            default: {
+                BDD_ID smallest = frontier;
+                size_t smallestSize = nodeCount(frontier);
+                for (BDD_ID candidate: {restrict(frontier, careSet), constrain(frontier, careSet)}) {
+                    size_t candidateSize = nodeCount(candidate);
+                    if (candidateSize < smallestSize) {
+                        smallest = candidate;
+                        smallestSize = candidateSize;
+                    }
+                }
+                return smallest;
+            }
         }
+    }
 
-        BDD_ID target = True();
+    BDD_ID Reachability::stateCube(const std::vector<bool> &stateVector) {
+        BDD_ID cube = True();
         for (size_t i = 0; i < currentStateVars.size(); i++) {
             if (stateVector[i]) {
-                target = and2(target, currentStateVars[i]);
+                cube = and2(cube, currentStateVars[i]);
             } else {
-                target = and2(target, neg(currentStateVars[i]));
+                cube = and2(cube, neg(currentStateVars[i]));
+            }
+        }
+        return cube;
+    }
+
+    void Reachability::prepareImageWorkers() {
+        std::vector<BDD_ID> vars;
+        for (BDD_ID id = 2; id < uniqueTableSize(); id++) {
+            if (isVariable(id)) {
+                vars.push_back(id);
+            }
+        }
+
+        size_t clusters = std::min<size_t>(imageThreads, transitionPartitions.size());
+        imageWorkers.clear();
+        workerClusters.clear();
+        clusterSupports.clear();
+        workerVarMap.assign(uniqueTableSize(), False());
+        masterVarMap.assign(vars.size() + 2, False());
+
+        for (size_t w = 0; w < clusters; w++) {
+            // Every worker creates the same variables in the same order, so workers share variable IDs
+            auto worker = std::make_unique<Manager>();
+            for (BDD_ID var: vars) {
+                BDD_ID local = worker->createVar(getTopVarName(var));
+                workerVarMap[var] = local;
+                masterVarMap[local] = var;
+            }
+
+            // Contiguous chunks of state bits, neighbouring bits tend to share support
+            BDD_ID cluster = True();
+            for (size_t i = w * transitionPartitions.size() / clusters;
+                 i < (w + 1) * transitionPartitions.size() / clusters; i++) {
+                cluster = and2(cluster, transitionPartitions[i]);
+            }
+
+            std::set<BDD_ID> support;
+            findVars(cluster, support);
+            clusterSupports.push_back(support);
+            workerClusters.push_back(worker->importFrom(*this, cluster, workerVarMap));
+            imageWorkers.push_back(std::move(worker));
+        }
+    }
+
+    BDD_ID Reachability::parallelImage(BDD_ID states) {
+        if (imageWorkers.empty()) {
+            prepareImageWorkers();
+        }
+
+        // Partial product of one subtree: lives in imageWorkers[worker] and depends on (at most) support
+        struct Operand {
+            size_t worker;
+            BDD_ID root;
+            std::set<BDD_ID> support;
+        };
+
+        auto toWorker = [&](const std::vector<BDD_ID> &vars) {
+            std::vector<BDD_ID> local;
+            for (BDD_ID var: vars) {
+                local.push_back(workerVarMap[var]);
+            }
+            return local;
+        };
+
+        // A variable can be quantified as soon as no other operand depends on it
+        std::set<BDD_ID> quantifiable(currentStateAndInputVars.begin(), currentStateAndInputVars.end());
+        auto quantifiableIn = [&](const std::set<BDD_ID> &support, const std::vector<Operand> &operands,
+                                  size_t first, size_t second) {
+            std::vector<BDD_ID> vars;
+            for (BDD_ID var: support) {
+                bool shared = false;
+                for (size_t o = 0; o < operands.size() && !shared; o++) {
+                    shared = o != first && o != second && operands[o].support.count(var) != 0;
+                }
+                if (!shared && quantifiable.count(var)) {
+                    vars.push_back(var);
+                }
+            }
+            return vars;
+        };
+
+        // Leaves: states AND cluster. The states are part of every leaf, so their support is shared
+        std::set<BDD_ID> statesSupport;
+        findVars(states, statesSupport);
+        std::vector<Operand> operands;
+        for (size_t w = 0; w < imageWorkers.size(); w++) {
+            std::set<BDD_ID> support = clusterSupports[w];
+            support.insert(statesSupport.begin(), statesSupport.end());
+            operands.push_back({w, False(), support});
+        }
+
+        std::vector<std::vector<BDD_ID>> quantified(operands.size());
+        std::vector<std::thread> threads;
+        for (size_t w = 0; w < operands.size(); w++) {
+            quantified[w] = quantifiableIn(operands[w].support, operands, w, w);
+            threads.emplace_back([&, w]() {
+                TraceSpan span("imageWorker", "reachability", static_cast<int64_t>(w));
+                // Every worker copies the states on its own thread, this manager is only read meanwhile
+                Manager &worker = *imageWorkers[w];
+                BDD_ID localStates = worker.importFrom(*this, states, workerVarMap);
+                operands[w].root = worker.andExists(localStates, workerClusters[w], toWorker(quantified[w]));
+            });
+        }
+        for (auto &thread: threads) {
+            thread.join();
+        }
+        for (size_t w = 0; w < operands.size(); w++) {
+            for (BDD_ID var: quantified[w]) {
+                operands[w].support.erase(var);
+            }
+        }
+
+        // Balanced conjunction tree, the pairs of one level are merged concurrently
+        std::vector<BDD_ID> workerIdentity(masterVarMap.size());
+        for (BDD_ID id = 0; id < workerIdentity.size(); id++) {
+            workerIdentity[id] = id;
+        }
+
+        while (operands.size() > 1) {
+            std::vector<Operand> merged;
+            threads.clear();
+            quantified.assign(operands.size() / 2, {});
+
+            for (size_t p = 0; p + 1 < operands.size(); p += 2) {
+                std::set<BDD_ID> support = operands[p].support;
+                support.insert(operands[p + 1].support.begin(), operands[p + 1].support.end());
+                quantified[p / 2] = quantifiableIn(support, operands, p, p + 1);
+                for (BDD_ID var: quantified[p / 2]) {
+                    support.erase(var);
+                }
+                merged.push_back({operands[p].worker, False(), support});
+            }
+            if (operands.size() % 2) {
+                merged.push_back(operands.back());
+            }
+
+            for (size_t p = 0; p + 1 < operands.size(); p += 2) {
+                threads.emplace_back([&, p]() {
+                    TraceSpan span("imageMerge", "reachability", static_cast<int64_t>(p / 2));
+                    // The right worker is idle on this level, reading its manager is safe
+                    Manager &left = *imageWorkers[operands[p].worker];
+                    BDD_ID right = left.importFrom(*imageWorkers[operands[p + 1].worker], operands[p + 1].root,
+                                                   workerIdentity);
+                    merged[p / 2].root = left.andExists(operands[p].root, right, toWorker(quantified[p / 2]));
+                });
+            }
+            for (auto &thread: threads) {
+                thread.join();
+            }
+            operands = std::move(merged);
+        }
+
+        // Quantify what is left, rename s' to s and copy the image back
+        Manager &root = *imageWorkers[operands[0].worker];
+        BDD_ID img = root.existQuantify(operands[0].root, toWorker(currentStateAndInputVars));
+        img = root.rename(img, toWorker(nextStateVars), toWorker(currentStateVars));
+        return importFrom(root, img, masterVarMap);
+    }
+
+    BDD_ID Reachability::image(BDD_ID states) {
+        TraceSpan span("image", "reachability");
+        if (imageThreads > 1) {
+            return parallelImage(states);
+        }
+
+        // Conjunction with Tau (s, x, s') and quantification of current states (s) and inputs (x) in one pass
+        BDD_ID img = andExists(states, transitionRelation, currentStateAndInputVars);
+        // img(s'): for the next iteration s' needs to be replaced with s
+        return rename(img, nextStateVars, currentStateVars);
+    }
+
+    BDD_ID Reachability::imageUnder(BDD_ID states, BDD_ID relation) {
+        BDD_ID img = andExists(states, relation, currentStateVars);
+        return rename(img, nextStateVars, currentStateVars);
+    }
+
+    BDD_ID Reachability::composeRelation(BDD_ID relation) {
+        // R(s, s'') and R(s'', s'), joined over the intermediate states s''
+        BDD_ID first = rename(relation, nextStateVars, intermediateStateVars);
+        BDD_ID second = rename(relation, currentStateVars, intermediateStateVars);
+        return andExists(first, second, intermediateStateVars);
+    }
+
+    int Reachability::squaringDistance(BDD_ID reached, int depth, BDD_ID target) {
+        // R_0(s, s'): at most one step. Inputs are quantified, the identity makes the relation reflexive
+        BDD_ID identity = True();
+        for (size_t i = 0; i < currentStateVars.size(); i++) {
+            identity = and2(identity, xnor2(currentStateVars[i], nextStateVars[i]));
+        }
+        std::vector<BDD_ID> relations = {or2(existQuantify(transitionRelation, inputVars), identity)};
+
+        // Square until the target is within 2^k steps of 'reached'. relations[k] covers at most 2^k steps
+        while (true) {
+            BDD_ID next = imageUnder(reached, relations.back());
+            if (and2(next, target) != False()) {
+                break;
+            }
+            if (next == reached) {
+                return -1; // Fixed point, every reachable state is already in 'reached'
+            }
+
+            BDD_ID squared = composeRelation(relations.back());
+            if (squared == relations.back()) {
+                return -1; // Transitive closure reached without hitting the target
+            }
+            relations.push_back(squared);
+        }
+
+        // Binary descent: take each power of two step that still misses the target
+        for (size_t k = relations.size() - 1; k-- > 0;) {
+            BDD_ID next = imageUnder(reached, relations[k]);
+            if (and2(next, target) == False()) {
+                reached = next;
+                depth += 1 << k;
+            }
+        }
+
+        // 'reached' misses the target, one more step hits it
+        return depth + 1;
+    }
+
+    BDD_ID Reachability::preImage(BDD_ID states) {
+        BDD_ID next = rename(states, currentStateVars, nextStateVars);
+        std::vector<BDD_ID> nextStateAndInputVars = nextStateVars;
+        nextStateAndInputVars.insert(nextStateAndInputVars.end(), inputVars.begin(), inputVars.end());
+        return andExists(next, transitionRelation, nextStateAndInputVars);
+    }
+
+    std::vector<bool> Reachability::pickState(BDD_ID states) {
+        std::vector<bool> state(currentStateVars.size(), false);
+
+        // Follow any path to True, bits not on the path keep the value false
+        BDD_ID node = states;
+        while (!isConstant(node)) {
+            bool high = coFactorTrue(node) != False();
+            for (size_t i = 0; i < currentStateVars.size(); i++) {
+                if (currentStateVars[i] == topVar(node)) {
+                    state[i] = high;
+                }
+            }
+            node = high ? coFactorTrue(node) : coFactorFalse(node);
+        }
+        return state;
+    }
+
+    double Reachability::countStates(BDD_ID states) {
+        // Fraction of all assignments in the set: each decision halves the weight of its branches
+        std::unordered_map<BDD_ID, double> density = {{False(), 0.0}, {True(), 1.0}};
+        std::set<BDD_ID> nodesOfStates;
+        findNodes(states, nodesOfStates);
+
+        // Children have smaller IDs than their parents
+        for (BDD_ID node: nodesOfStates) {
+            if (!isConstant(node)) {
+                density[node] = (density[coFactorTrue(node)] + density[coFactorFalse(node)]) / 2;
+            }
+        }
+
+        return density[states] * std::pow(2.0, static_cast<double>(currentStateVars.size()));
+    }
+
+    InvariantResult Reachability::checkInvariant(BDD_ID property) {
+        if (property >= uniqueTableSize()) {
+            throw std::runtime_error("Unknown ID provided");
+        }
+
+        // Frontiers are kept to walk back from the bad state
+        std::vector<BDD_ID> frontiers = {initialState};
+        BDD_ID visited = initialState;
+
+        while (frontiers.back() != False()) {
+            TraceSpan span("iteration", "reachability", static_cast<int64_t>(frontiers.size()) - 1);
+            BDD_ID CR = frontiers.back();
+
+            // frontier -> property is checked on the existing nodes, the conjunction is only built on a violation
+            if (!implies(CR, property)) {
+                int depth = static_cast<int>(frontiers.size()) - 1;
+                std::vector<std::vector<bool>> trace(frontiers.size());
+
+                BDD_ID state = stateCube(pickState(and2(CR, neg(property))));
+                trace.back() = pickState(state);
+                for (int step = depth - 1; step >= 0; step--) {
+                    // Some predecessor of the current trace state was part of the previous frontier
+                    state = stateCube(pickState(and2(frontiers[step], preImage(state))));
+                    trace[step] = pickState(state);
+                }
+
+                return {false, depth, visited, trace};
             }
+
+            BDD_ID next_CR = ite(visited, False(), image(simplifyFrontier(CR, visited)));
+            visited = or2(visited, next_CR);
+            frontiers.push_back(next_CR);
+        }
+
+        return {true, static_cast<int>(frontiers.size()) - 2, visited, {}};
+    }
+
+    int Reachability::stateDistance(const std::vector<bool> &stateVector) {
+        if (stateVector.size() != currentStateVars.size()) {
+            throw std::runtime_error("Size mismatch");
+        }
+
+        BDD_ID target = stateCube(stateVector);
+
+        if (traversalMode == TraversalMode::IterativeSquaring) {
+            if (and2(target, initialState) != False()) {
+                return 0;
+            }
+            return squaringDistance(initialState, 0, target);
         }
 
         // 'CR': Current Reachable states. Starts with just Initial State.
@@ -98,46 +464,29 @@ namespace ClassProject {
         BDD_ID visited = CR;
 
         int distance = 0;
+        unsigned int smallFrontiers = 0;
 
         // Loop until CR holds. If it is False, no new states
         while (CR != False()) {
+            TraceSpan span("iteration", "reachability", distance);
             if (and2(target, CR) != False()) {
                 // Does target exists in CR
                 // fixed point reached. CR is now the symbolic representation of the set of reachable states
                 return distance;
             }
 
-            // Image Computation
-
-            // Conjunction of CR and Tau (s, x, s')
-            BDD_ID temp = and2(CR, transitionRelation);
-
-            // Quantify out Current State (s) and Inputs (x). CoFactor (from Manager) is equivalent
-            // Quantify States (s0, s1, ...)
-            for (auto &var: currentStateVars) {
-                temp = or2(coFactorTrue(temp, var), coFactorFalse(temp, var));
-            }
-
-            // Quantify Inputs (x, ...)
-            for (auto &var: inputVars) {
-                temp = or2(coFactorTrue(temp, var), coFactorFalse(temp, var));
-            }
-            // temp: img(s'). Consists of only next states, described using s'
-
-            // For the next iteration s' needs to be replaced with s by equality mapping
-            BDD_ID mapping = True();
-            for (size_t i = 0; i < currentStateVars.size(); i++) {
-                mapping = and2(mapping, xnor2(currentStateVars[i], nextStateVars[i]));
-            }
-
-            BDD_ID temp2 = and2(temp, mapping);
-
-            // Quantify next state vars (s')
-            for (auto &var: nextStateVars) {
-                temp2 = or2(coFactorTrue(temp2, var), coFactorFalse(temp2, var));
+            if (traversalMode == TraversalMode::Auto) {
+                // Deep designs like counters keep a tiny frontier for many steps, squaring needs O(log) steps there
+                smallFrontiers = (nodeCount(CR) <= squaringFrontierLimit) ? smallFrontiers + 1 : 0;
+                if (smallFrontiers >= squaringSwitchIterations) {
+                    return squaringDistance(visited, distance, target);
+                }
             }
 
-            // temp2: img(s). All sets reachable in next step
+            // Image Computation
+            // temp2: img(s). All sets reachable in next step. Already visited states may be added to CR,
+            // their successors are visited as well and get removed again below
+            BDD_ID temp2 = image(simplifyFrontier(CR, visited));
 
             // Save only new states. If already visited no new states, else img(s)
             BDD_ID next_CR = ite(visited, False(), temp2);
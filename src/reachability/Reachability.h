@@ -2,20 +2,94 @@
 #define VDSPROJECT_REACHABILITY_H
 
 #include <vector>
+#include <set>
+#include <memory>
 
 #include "ReachabilityInterface.h"
 #include "../ManagerInterface.h"
 
 namespace ClassProject {
+    // How stateDistance traverses the state space
+    enum class TraversalMode {
+        BFS, // One image per step
+        IterativeSquaring, // Images under T^(2^k), O(k) steps for deep designs
+        Auto // BFS, switches to squaring once the frontier stays small for many iterations
+    };
+
+    // Which set between the exact frontier and frontier OR visited is handed to the image computation
+    enum class FrontierSimplification {
+        None, // Exact frontier
+        Restrict, // Coudert-Madre restrict with the visited states as don't cares
+        Constrain, // Generalized cofactor with the visited states as don't cares
+        Minimize // Smallest BDD out of the exact, restricted and constrained frontier
+    };
+
+    // Outcome of Reachability::checkInvariant
+    struct InvariantResult {
+        bool holds; // true: the property holds in every reachable state
+        int depth; // holds: distance of the farthest reachable state, violated: distance of the first bad state
+        BDD_ID reachable; // holds: all reachable states (proof of invariance), violated: states within depth steps
+        std::vector<std::vector<bool>> trace; // violated: shortest path from the initial to a bad state
+    };
+
     class Reachability : public ReachabilityInterface {
     private:
         std::vector<BDD_ID> currentStateVars; // Current state bits (s0, s1, ...)
         std::vector<BDD_ID> nextStateVars; // Next state bits (s0', s1', ...)
+        std::vector<BDD_ID> intermediateStateVars; // Intermediate state bits (s0'', s1'', ...) for squaring
         std::vector<BDD_ID> inputVars; // Input bits (x, ...)
+        std::vector<BDD_ID> currentStateAndInputVars; // Quantified during image computation
 
         BDD_ID transitionRelation; // Tau (s, x, s')
+        std::vector<BDD_ID> transitionPartitions; // Tau_i (s, x, s_i') = s_i' XNOR delta_i(s, x), one per state bit
         BDD_ID initialState; // Characteristic Function of initial state
 
+        TraversalMode traversalMode = TraversalMode::BFS;
+        size_t squaringFrontierLimit = 64; // Auto: frontier counts as small up to this many nodes
+        unsigned int squaringSwitchIterations = 16; // Auto: small frontier iterations before switching
+
+        FrontierSimplification frontierSimplification = FrontierSimplification::None;
+
+        unsigned int imageThreads = 1; // More than one: partitioned image on thread-local managers
+        std::vector<std::unique_ptr<Manager>> imageWorkers; // One manager per cluster, same variables as this one
+        std::vector<BDD_ID> workerClusters; // Conjunction of the cluster's partitions, in the worker's manager
+        std::vector<std::set<BDD_ID>> clusterSupports; // Variables each cluster depends on
+        std::vector<BDD_ID> workerVarMap; // Variable mapping from this manager to the workers
+        std::vector<BDD_ID> masterVarMap; // Variable mapping from the workers back to this manager
+
+        // Characteristic function of a single state
+        BDD_ID stateCube(const std::vector<bool> &stateVector);
+
+        // Number of nodes of the BDD rooted at f
+        size_t nodeCount(BDD_ID f);
+
+        // Any set between 'frontier' and 'frontier OR visited', picked by the frontier simplification strategy
+        BDD_ID simplifyFrontier(BDD_ID frontier, BDD_ID visited);
+
+        // img(s): states reachable in one step from 'states', expressed over the current state variables
+        BDD_ID image(BDD_ID states);
+
+        // Splits the partitions into one cluster per thread and copies them to the worker managers
+        void prepareImageWorkers();
+
+        // img(s) with the partial products of the clusters computed concurrently and conjoined in a balanced tree
+        BDD_ID parallelImage(BDD_ID states);
+
+        // pre(s): states with a successor in 'states'
+        BDD_ID preImage(BDD_ID states);
+
+        // One state out of a non-empty set of states
+        std::vector<bool> pickState(BDD_ID states);
+
+        // States reachable from 'states' under a relation R(s, s')
+        BDD_ID imageUnder(BDD_ID states, BDD_ID relation);
+
+        // R(s, s'') = exists s'. R(s, s') AND R(s', s'')
+        BDD_ID composeRelation(BDD_ID relation);
+
+        // Distance of 'target' given that 'reached' holds exactly the states within 'depth' steps
+        int squaringDistance(BDD_ID reached, int depth, BDD_ID target);
+
     public:
         explicit Reachability(unsigned int stateSize, unsigned int inputSize = 0); // Constructor
 
@@ -30,6 +104,29 @@ namespace ClassProject {
         void setTransitionFunctions(const std::vector<BDD_ID> &transitionFunctions) override;
 
         void setInitState(const std::vector<bool> &stateVector) override;
+
+        /**
+         * Proves that 'property' (a function of the state bits) holds in every reachable state.
+         * The forward traversal stops at the first frontier with a state violating the property.
+         *
+         * @param property BDD of the states considered good
+         * @returns depth and reachable states if the property holds, depth and a trace to a bad state otherwise
+         * @throws std::runtime_error if an unknown ID is provided
+         */
+        InvariantResult checkInvariant(BDD_ID property);
+
+        // Number of states in a set of states
+        double countStates(BDD_ID states);
+
+        void setTraversalMode(TraversalMode mode);
+
+        // Auto mode: switch to squaring after 'iterations' consecutive frontiers of at most 'maxFrontierNodes' nodes
+        void setSquaringThreshold(size_t maxFrontierNodes, unsigned int iterations);
+
+        void setFrontierSimplification(FrontierSimplification strategy);
+
+        // Number of threads for the image computation, 1 keeps the monolithic image
+        void setImageThreads(unsigned int threads);
     };
 }
 #endif
@@ -243,4 +243,191 @@ TEST_F(ReachabilityTest, FSM_3Bit_Control_2Inputs) { /* NOLINT */
     EXPECT_EQ(fsm->stateDistance({false, false, true}), 4);
 }
 
+// 6-bit wrapping counter with enable, deep enough that squaring pays off
+// Distances are checked against plain BFS for all traversal modes
+TEST_F(ReachabilityTest, IterativeSquaring_DeepCounter) { /* NOLINT */
+    const unsigned int bits = 6;
+
+    auto buildCounter = [&](ClassProject::Reachability &fsm) {
+        auto states = fsm.getStates();
+        BDD_ID carry = fsm.getInputs().at(0);
+        std::vector<BDD_ID> next;
+        for (unsigned int i = 0; i < bits; i++) {
+            next.push_back(fsm.xor2(states[i], carry));
+            carry = fsm.and2(states[i], carry);
+        }
+        fsm.setTransitionFunctions(next);
+    };
+
+    auto toVector = [&](unsigned int value) {
+        std::vector<bool> state;
+        for (unsigned int i = 0; i < bits; i++) {
+            state.push_back((value >> i) & 1u);
+        }
+        return state;
+    };
+
+    ClassProject::Reachability bfs(bits, 1);
+    ClassProject::Reachability squaring(bits, 1);
+    ClassProject::Reachability automatic(bits, 1);
+    buildCounter(bfs);
+    buildCounter(squaring);
+    buildCounter(automatic);
+    squaring.setTraversalMode(ClassProject::TraversalMode::IterativeSquaring);
+    automatic.setTraversalMode(ClassProject::TraversalMode::Auto);
+    automatic.setSquaringThreshold(64, 4);
+
+    for (unsigned int value : {0u, 1u, 5u, 32u, 47u, 63u}) {
+        int expected = static_cast<int>(value);
+        EXPECT_EQ(bfs.stateDistance(toVector(value)), expected);
+        EXPECT_EQ(squaring.stateDistance(toVector(value)), expected);
+        EXPECT_EQ(automatic.stateDistance(toVector(value)), expected);
+    }
+
+    // Counting from 40 wraps around, 39 is the farthest state
+    bfs.setInitState(toVector(40));
+    squaring.setInitState(toVector(40));
+    automatic.setInitState(toVector(40));
+    EXPECT_EQ(squaring.stateDistance(toVector(39)), 63);
+    EXPECT_EQ(automatic.stateDistance(toVector(39)), 63);
+    EXPECT_EQ(squaring.stateDistance(toVector(2)), bfs.stateDistance(toVector(2)));
+}
+
+TEST_F(ReachabilityTest, IterativeSquaring_Unreachable) { /* NOLINT */
+    // Saturating 2-bit shift register: s0' = 1, s1' = s0. State {false, true} is never reached from 00
+    BDD_ID s0 = stateVars2.at(0);
+    auto *fsm = dynamic_cast<ClassProject::Reachability *>(fsm2.get());
+    fsm->setTransitionFunctions({fsm->True(), s0});
+    fsm->setTraversalMode(ClassProject::TraversalMode::IterativeSquaring);
+
+    EXPECT_EQ(fsm->stateDistance({false, false}), 0);
+    EXPECT_EQ(fsm->stateDistance({true, false}), 1);
+    EXPECT_EQ(fsm->stateDistance({true, true}), 2);
+    EXPECT_EQ(fsm->stateDistance({false, true}), -1);
+    EXPECT_FALSE(fsm->isReachable({false, true}));
+}
+
+// Don't care based frontier simplification must not change any distance
+TEST_F(ReachabilityTest, FrontierSimplification_KeepsDistances) { /* NOLINT */
+    auto buildUpDown = [](ClassProject::Reachability &fsm) {
+        auto states = fsm.getStates();
+        BDD_ID enable = fsm.getInputs().at(0);
+        BDD_ID down = fsm.getInputs().at(1);
+        // carry for counting up, borrow for counting down
+        BDD_ID carry = fsm.True();
+        BDD_ID borrow = fsm.True();
+        std::vector<BDD_ID> next;
+        for (BDD_ID s: states) {
+            BDD_ID toggle = fsm.and2(enable, fsm.ite(down, borrow, carry));
+            next.push_back(fsm.xor2(s, toggle));
+            carry = fsm.and2(carry, s);
+            borrow = fsm.and2(borrow, fsm.neg(s));
+        }
+        fsm.setTransitionFunctions(next);
+    };
+
+    const unsigned int bits = 4;
+    ClassProject::Reachability reference(bits, 2);
+    buildUpDown(reference);
+
+    for (auto strategy: {ClassProject::FrontierSimplification::Restrict,
+                         ClassProject::FrontierSimplification::Constrain,
+                         ClassProject::FrontierSimplification::Minimize}) {
+        ClassProject::Reachability fsm(bits, 2);
+        buildUpDown(fsm);
+        fsm.setFrontierSimplification(strategy);
+        for (unsigned int value = 0; value < (1u << bits); value++) {
+            std::vector<bool> state;
+            for (unsigned int i = 0; i < bits; i++) {
+                state.push_back((value >> i) & 1u);
+            }
+            EXPECT_EQ(fsm.stateDistance(state), reference.stateDistance(state));
+        }
+    }
+    EXPECT_EQ(reference.stateDistance({false, false, false, true}), 8);
+}
+
+// Partitioned image on worker threads must match the monolithic image
+TEST_F(ReachabilityTest, ParallelImage_MatchesMonolithic) { /* NOLINT */
+    // 5-bit LFSR-like register with an input that may flip the feedback
+    auto build = [](ClassProject::Reachability &fsm) {
+        auto states = fsm.getStates();
+        BDD_ID in = fsm.getInputs().at(0);
+        std::vector<BDD_ID> next = {fsm.xor2(fsm.xor2(states[4], states[2]), in)};
+        for (size_t i = 1; i < states.size(); i++) {
+            next.push_back(states[i - 1]);
+        }
+        fsm.setTransitionFunctions(next);
+    };
+
+    ClassProject::Reachability reference(5, 1);
+    build(reference);
+
+    for (unsigned int threads: {2u, 3u, 8u}) {
+        ClassProject::Reachability fsm(5, 1);
+        build(fsm);
+        fsm.setImageThreads(threads);
+        fsm.setFrontierSimplification(ClassProject::FrontierSimplification::Restrict);
+        for (unsigned int value = 0; value < 32; value++) {
+            std::vector<bool> state;
+            for (unsigned int i = 0; i < 5; i++) {
+                state.push_back((value >> i) & 1u);
+            }
+            EXPECT_EQ(fsm.stateDistance(state), reference.stateDistance(state));
+        }
+    }
+
+    // Variables created after the state machine must not confuse the worker variable mapping
+    ClassProject::Reachability fsm(2);
+    fsm.createVar("unrelated");
+    fsm.setTransitionFunctions({fsm.neg(fsm.getStates().at(1)), fsm.getStates().at(0)});
+    fsm.setImageThreads(2);
+    EXPECT_EQ(fsm.stateDistance({true, false}), 1);
+    EXPECT_EQ(fsm.stateDistance({true, true}), 2);
+    EXPECT_EQ(fsm.stateDistance({false, true}), 3);
+}
+
+TEST_F(ReachabilityTest, CheckInvariant_ProofAndCounterexample) { /* NOLINT */
+    // 3-bit counter with enable, 111 is bad
+    ClassProject::Reachability fsm(3, 1);
+    auto states = fsm.getStates();
+    BDD_ID carry = fsm.getInputs().at(0);
+    std::vector<BDD_ID> next;
+    for (BDD_ID s: states) {
+        next.push_back(fsm.xor2(s, carry));
+        carry = fsm.and2(s, carry);
+    }
+    fsm.setTransitionFunctions(next);
+
+    BDD_ID allOnes = fsm.and2(states[0], fsm.and2(states[1], states[2]));
+    auto result = fsm.checkInvariant(fsm.neg(allOnes));
+    EXPECT_FALSE(result.holds);
+    EXPECT_EQ(result.depth, 7);
+    ASSERT_EQ(result.trace.size(), 8u);
+    EXPECT_EQ(result.trace.front(), std::vector<bool>({false, false, false}));
+    EXPECT_EQ(result.trace.back(), std::vector<bool>({true, true, true}));
+    for (size_t step = 0; step < result.trace.size(); step++) {
+        EXPECT_EQ(fsm.stateDistance(result.trace[step]), static_cast<int>(step));
+    }
+
+    // Saturating shift register s0' = 1, s1' = s0 never reaches {false, true}
+    BDD_ID s0 = stateVars2.at(0);
+    BDD_ID s1 = stateVars2.at(1);
+    auto *fsm2Impl = dynamic_cast<ClassProject::Reachability *>(fsm2.get());
+    fsm2Impl->setTransitionFunctions({fsm2Impl->True(), s0});
+    BDD_ID bad = fsm2Impl->and2(fsm2Impl->neg(s0), s1);
+
+    auto proof = fsm2Impl->checkInvariant(fsm2Impl->neg(bad));
+    EXPECT_TRUE(proof.holds);
+    EXPECT_EQ(proof.depth, 2);
+    EXPECT_EQ(proof.reachable, fsm2Impl->neg(bad));
+    EXPECT_TRUE(proof.trace.empty());
+
+    // Violated in the initial state already
+    auto initial = fsm2Impl->checkInvariant(s0);
+    EXPECT_FALSE(initial.holds);
+    EXPECT_EQ(initial.depth, 0);
+    EXPECT_THROW(fsm2Impl->checkInvariant(999999), std::runtime_error);
+}
+
 #endif
@@ -636,6 +636,412 @@ TEST_F(ManagerTest, CoFactorTrueTest) /* NOLINT */
 }
 
 
+TEST_F(ManagerTest, AndExists_QuantifiesDuringConjunction) /* NOLINT */
+{
+    BDD_ID a_id = manager.createVar("a");
+    BDD_ID b_id = manager.createVar("b");
+    BDD_ID c_id = manager.createVar("c");
+
+    // exists b. (a AND b) AND (b OR c) = a
+    BDD_ID f = manager.and2(a_id, b_id);
+    BDD_ID g = manager.or2(b_id, c_id);
+    EXPECT_EQ(manager.andExists(f, g, {b_id}), a_id);
+
+    // exists b. (a AND b) AND (NOT b) = False
+    EXPECT_EQ(manager.andExists(f, manager.neg(b_id), {b_id}), FALSE_ID);
+
+    // Matches the conjunction followed by cofactor based quantification
+    BDD_ID h = manager.xor2(a_id, manager.and2(b_id, c_id));
+    BDD_ID conj = manager.and2(h, g);
+    BDD_ID expected = manager.or2(manager.coFactorTrue(conj, b_id), manager.coFactorFalse(conj, b_id));
+    EXPECT_EQ(manager.andExists(h, g, {b_id}), expected);
+
+    EXPECT_EQ(manager.existQuantify(h, {a_id, b_id, c_id}), TRUE_ID);
+}
+
+TEST_F(ManagerTest, Rename_ReplacesVariables) /* NOLINT */
+{
+    BDD_ID a_id = manager.createVar("a");
+    BDD_ID b_id = manager.createVar("b");
+    BDD_ID c_id = manager.createVar("c");
+    BDD_ID d_id = manager.createVar("d");
+
+    // (a AND NOT b)[c/a, d/b] = c AND NOT d
+    BDD_ID f = manager.and2(a_id, manager.neg(b_id));
+    EXPECT_EQ(manager.rename(f, {a_id, b_id}, {c_id, d_id}), manager.and2(c_id, manager.neg(d_id)));
+
+    // Mappings against the variable order and swaps are simultaneous
+    BDD_ID g = manager.and2(c_id, manager.neg(d_id));
+    EXPECT_EQ(manager.rename(g, {c_id, d_id}, {d_id, c_id}), manager.and2(d_id, manager.neg(c_id)));
+
+    EXPECT_THROW(manager.rename(f, {a_id}, {}), std::runtime_error);
+}
+
+
+TEST_F(ManagerTest, RestrictAndConstrain_AgreeOnCareSet) /* NOLINT */
+{
+    BDD_ID a_id = manager.createVar("a");
+    BDD_ID b_id = manager.createVar("b");
+    BDD_ID c_id = manager.createVar("c");
+
+    BDD_ID f = manager.or2(manager.and2(a_id, b_id), manager.and2(manager.neg(a_id), c_id));
+    BDD_ID care = manager.or2(a_id, b_id);
+
+    BDD_ID restricted = manager.restrict(f, care);
+    BDD_ID constrained = manager.constrain(f, care);
+    EXPECT_EQ(manager.and2(restricted, care), manager.and2(f, care));
+    EXPECT_EQ(manager.and2(constrained, care), manager.and2(f, care));
+
+    // Care set a: f only matters for a = 1, where it is b
+    EXPECT_EQ(manager.restrict(f, a_id), b_id);
+    EXPECT_EQ(manager.constrain(f, a_id), b_id);
+
+    // Trivial care sets
+    EXPECT_EQ(manager.restrict(f, TRUE_ID), f);
+    EXPECT_EQ(manager.constrain(f, TRUE_ID), f);
+    EXPECT_EQ(manager.restrict(f, f), TRUE_ID);
+}
+
+
+TEST_F(ManagerTest, ImportFrom_CopiesBetweenManagers) /* NOLINT */
+{
+    BDD_ID a_id = manager.createVar("a");
+    BDD_ID b_id = manager.createVar("b");
+    BDD_ID f = manager.or2(manager.and2(a_id, b_id), manager.neg(a_id));
+
+    // Target manager with the variables created in reverse order
+    Manager other;
+    BDD_ID other_b = other.createVar("b");
+    BDD_ID other_a = other.createVar("a");
+    std::vector<BDD_ID> varMap(manager.uniqueTableSize(), FALSE_ID);
+    varMap[a_id] = other_a;
+    varMap[b_id] = other_b;
+
+    BDD_ID copy = other.importFrom(manager, f, varMap);
+    EXPECT_EQ(copy, other.or2(other.and2(other_a, other_b), other.neg(other_a)));
+    EXPECT_EQ(other.importFrom(manager, TRUE_ID, varMap), TRUE_ID);
+    EXPECT_EQ(other.importFrom(manager, FALSE_ID, varMap), FALSE_ID);
+}
+
+
+TEST_F(ManagerTest, ImportFrom_ThrowsOnUnmappedVariable) /* NOLINT */
+{
+    BDD_ID a_id = manager.createVar("a");
+    BDD_ID b_id = manager.createVar("b");
+    BDD_ID f = manager.and2(a_id, b_id);
+
+    Manager other;
+    BDD_ID other_a = other.createVar("a");
+    BDD_ID other_ab = other.and2(other_a, other.createVar("c"));
+    std::vector<BDD_ID> varMap(manager.uniqueTableSize(), FALSE_ID);
+    varMap[a_id] = other_a;
+    EXPECT_THROW(other.importFrom(manager, f, varMap), std::runtime_error) << "b is mapped to False.";
+
+    varMap[b_id] = other_ab;
+    EXPECT_THROW(other.importFrom(manager, f, varMap), std::runtime_error) << "b is mapped to a function.";
+
+    varMap[b_id] = other.uniqueTableSize();
+    EXPECT_THROW(other.importFrom(manager, f, varMap), std::runtime_error) << "b is mapped to an unknown ID.";
+
+    EXPECT_EQ(other.importFrom(manager, a_id, varMap), other_a) << "Only the variables of the roots must be mapped.";
+}
+
+TEST_F(ManagerTest, ImportFrom_BatchSharesSubgraphs) /* NOLINT */
+{
+    BDD_ID a_id = manager.createVar("a");
+    BDD_ID b_id = manager.createVar("b");
+    BDD_ID c_id = manager.createVar("c");
+    BDD_ID shared = manager.xor2(b_id, c_id);
+    BDD_ID f = manager.and2(a_id, shared);
+    BDD_ID g = manager.or2(a_id, shared);
+
+    // Same order and labels, so the variables map by label onto fresh ones
+    Manager other;
+    std::vector<BDD_ID> varMap = other.mapVariablesByLabel(manager);
+    std::vector<BDD_ID> copies = other.importFrom(manager, {f, g, shared, TRUE_ID}, varMap);
+    ASSERT_EQ(copies.size(), 4);
+    EXPECT_EQ(copies[0], other.and2(varMap[a_id], copies[2]));
+    EXPECT_EQ(copies[1], other.or2(varMap[a_id], copies[2]));
+    EXPECT_EQ(copies[2], other.xor2(varMap[b_id], varMap[c_id]));
+    EXPECT_EQ(copies[3], TRUE_ID);
+    EXPECT_EQ(other.uniqueTableSize(), manager.uniqueTableSize()) << "Shared subgraphs must be copied once.";
+}
+
+
+TEST_F(ManagerTest, ImportFrom_MapsVariablesByLabel) /* NOLINT */
+{
+    BDD_ID a_id = manager.createVar("a");
+    BDD_ID b_id = manager.createVar("b");
+    BDD_ID f = manager.and2(a_id, manager.neg(b_id));
+
+    // b exists with another ID, a is created by the mapping
+    Manager other;
+    other.createVar("x");
+    BDD_ID other_b = other.createVar("b");
+    std::vector<BDD_ID> varMap = other.mapVariablesByLabel(manager);
+    EXPECT_EQ(varMap[b_id], other_b);
+    EXPECT_EQ(other.getTopVarName(varMap[a_id]), "a");
+    EXPECT_EQ(other.importFrom(manager, f, varMap), other.and2(varMap[a_id], other.neg(other_b)));
+}
+
+
+TEST_F(ManagerTest, ImportFrom_DeepBDD) /* NOLINT */
+{
+    // A conjunction of many variables is a chain as deep as the number of variables
+    const size_t depth = 200000;
+    std::vector<BDD_ID> vars;
+    for (size_t i = 0; i < depth; i++) {
+        vars.push_back(manager.createVar("x" + std::to_string(i)));
+    }
+    BDD_ID f = TRUE_ID;
+    for (size_t i = depth; i-- > 0;) {
+        f = manager.and2(vars[i], f);
+    }
+
+    Manager other;
+    std::vector<BDD_ID> varMap = other.mapVariablesByLabel(manager);
+    BDD_ID copy = other.importFrom(manager, f, varMap);
+    EXPECT_EQ(other.topVar(copy), varMap[vars[0]]);
+    EXPECT_EQ(other.uniqueTableSize(), manager.uniqueTableSize());
+}
+
+
+TEST_F(ManagerTest, Implies_CreatesNoNodes) /* NOLINT */
+{
+    BDD_ID a_id = manager.createVar("a");
+    BDD_ID b_id = manager.createVar("b");
+    BDD_ID c_id = manager.createVar("c");
+    BDD_ID ab = manager.and2(a_id, b_id);
+    BDD_ID b_or_c = manager.or2(b_id, c_id);
+
+    size_t size = manager.uniqueTableSize();
+    EXPECT_TRUE(manager.implies(ab, b_or_c));
+    EXPECT_TRUE(manager.implies(FALSE_ID, ab));
+    EXPECT_TRUE(manager.implies(ab, TRUE_ID));
+    EXPECT_FALSE(manager.implies(b_or_c, ab));
+    EXPECT_FALSE(manager.implies(a_id, c_id));
+    EXPECT_FALSE(manager.implies(TRUE_ID, a_id));
+    EXPECT_EQ(manager.uniqueTableSize(), size) << "implies must not create nodes.";
+}
+
+
+TEST_F(ManagerTest, GarbageCollect_KeepsRootsAndVariables) /* NOLINT */
+{
+    BDD_ID a_id = manager.createVar("a");
+    BDD_ID b_id = manager.createVar("b");
+    manager.xor2(a_id, b_id);
+    BDD_ID f = manager.or2(manager.and2(a_id, b_id), manager.neg(a_id));
+    BDD_ID c_id = manager.createVar("c");
+    BDD_ID g = manager.and2(f, c_id);
+    size_t size_g = 0;
+    {
+        std::set<BDD_ID> nodes_of_g;
+        manager.findNodes(g, nodes_of_g);
+        size_g = nodes_of_g.size();
+    }
+
+    std::vector<BDD_ID> roots = {g};
+    size_t size = manager.uniqueTableSize();
+    size_t freed = manager.garbageCollect(roots);
+    EXPECT_GT(freed, 0u);
+    EXPECT_EQ(manager.uniqueTableSize(), size - freed);
+
+    // Variables keep their names and order, the root still computes the same function
+    std::set<BDD_ID> vars;
+    manager.findVars(roots[0], vars);
+    ASSERT_EQ(vars.size(), 3u);
+    std::vector<BDD_ID> var_ids(vars.begin(), vars.end());
+    EXPECT_EQ(manager.getTopVarName(var_ids[0]), "a");
+    EXPECT_EQ(manager.getTopVarName(var_ids[1]), "b");
+    EXPECT_EQ(manager.getTopVarName(var_ids[2]), "c");
+
+    std::set<BDD_ID> nodes_of_g;
+    manager.findNodes(roots[0], nodes_of_g);
+    EXPECT_EQ(nodes_of_g.size(), size_g);
+    BDD_ID rebuilt = manager.and2(manager.or2(manager.and2(var_ids[0], var_ids[1]), manager.neg(var_ids[0])), var_ids[2]);
+    EXPECT_EQ(rebuilt, roots[0]);
+}
+
+
+TEST_F(ManagerTest, StructuralHash_IndependentOfIds) /* NOLINT */
+{
+    BDD_ID a_id = manager.createVar("a");
+    BDD_ID b_id = manager.createVar("b");
+    BDD_ID c_id = manager.createVar("c");
+    BDD_ID f = manager.or2(manager.and2(a_id, b_id), c_id);
+
+    // Same variables, but other nodes first, so f gets another ID
+    Manager other;
+    BDD_ID other_a = other.createVar("a");
+    BDD_ID other_b = other.createVar("b");
+    BDD_ID other_c = other.createVar("c");
+    other.xor2(other_a, other_c);
+    other.nand2(other_b, other_c);
+    BDD_ID other_f = other.or2(other.and2(other_a, other_b), other_c);
+    ASSERT_NE(f, other_f);
+
+    EXPECT_EQ(manager.structuralHash(f), other.structuralHash(other_f));
+    EXPECT_EQ(manager.structuralHash(f), manager.structuralHash(f)) << "Cached hashes must not change.";
+    EXPECT_EQ(manager.structuralHash(FALSE_ID), other.structuralHash(FALSE_ID));
+    EXPECT_NE(manager.structuralHash(FALSE_ID), manager.structuralHash(TRUE_ID));
+    EXPECT_NE(manager.structuralHash(f), manager.structuralHash(manager.neg(f)));
+    EXPECT_NE(manager.structuralHash(a_id), manager.structuralHash(manager.neg(a_id)));
+    EXPECT_NE(manager.structuralHash(a_id), manager.structuralHash(b_id));
+}
+
+
+TEST_F(ManagerTest, StructuralHash_DependsOnNamesAndSurvivesGarbageCollection) /* NOLINT */
+{
+    BDD_ID a_id = manager.createVar("a");
+    BDD_ID b_id = manager.createVar("b");
+    manager.or2(a_id, b_id);
+    BDD_ID f = manager.and2(a_id, manager.neg(b_id));
+    uint64_t hash = manager.structuralHash(f);
+
+    Manager renamed;
+    BDD_ID x_id = renamed.createVar("a");
+    BDD_ID y_id = renamed.createVar("y");
+    EXPECT_NE(renamed.structuralHash(renamed.and2(x_id, renamed.neg(y_id))), hash);
+
+    std::vector<BDD_ID> roots = {f};
+    ASSERT_GT(manager.garbageCollect(roots), 0u);
+    EXPECT_EQ(manager.structuralHash(roots[0]), hash);
+    EXPECT_EQ(manager.structuralHash(manager.and2(a_id, manager.neg(b_id))), hash);
+}
+
+
+TEST_F(ManagerTest, StructuralHash_OfRootCreatedAfterCachingSurvivesGarbageCollection) /* NOLINT */
+{
+    BDD_ID a_id = manager.createVar("a");
+    BDD_ID b_id = manager.createVar("b");
+    BDD_ID c_id = manager.createVar("c");
+    // The dead nodes get their hashes cached before the root exists, its new ID is one of their old slots
+    manager.structuralHash(manager.or2(a_id, b_id));
+    manager.structuralHash(manager.xor2(b_id, c_id));
+    BDD_ID f = manager.and2(a_id, c_id);
+
+    Manager reference;
+    BDD_ID x_id = reference.createVar("a");
+    reference.createVar("b");
+    BDD_ID z_id = reference.createVar("c");
+    uint64_t hash = reference.structuralHash(reference.and2(x_id, z_id));
+
+    std::vector<BDD_ID> roots = {f};
+    ASSERT_GT(manager.garbageCollect(roots), 0u);
+    EXPECT_EQ(manager.structuralHash(roots[0]), hash);
+}
+
+TEST_F(ManagerTest, ComputedTableSize_CountsCachedResults) /* NOLINT */
+{
+    EXPECT_EQ(manager.computedTableSize(), 0u);
+    BDD_ID a_id = manager.createVar("a");
+    BDD_ID b_id = manager.createVar("b");
+    BDD_ID f = manager.and2(a_id, b_id);
+    size_t cached = manager.computedTableSize();
+    EXPECT_GT(cached, 0u);
+    manager.and2(a_id, b_id);
+    EXPECT_EQ(manager.computedTableSize(), cached) << "A repeated operation must be answered from the cache.";
+
+    std::vector<BDD_ID> roots = {f};
+    manager.garbageCollect(roots);
+    EXPECT_EQ(manager.computedTableSize(), 0u);
+}
+
+
+TEST_F(ManagerTest, NodeCount_MatchesFindNodes) /* NOLINT */
+{
+    BDD_ID a_id = manager.createVar("a");
+    BDD_ID b_id = manager.createVar("b");
+    BDD_ID c_id = manager.createVar("c");
+    std::vector<BDD_ID> roots = {FALSE_ID, TRUE_ID, a_id, manager.xor2(a_id, manager.and2(b_id, c_id)),
+                                 manager.or2(manager.neg(a_id), c_id)};
+    for (BDD_ID root : roots) {
+        std::set<BDD_ID> nodes;
+        manager.findNodes(root, nodes);
+        EXPECT_EQ(manager.nodeCount(root), nodes.size()) << "Root " << root;
+    }
+
+    // Nodes created after a count are counted as well
+    BDD_ID f = manager.and2(roots[3], roots[4]);
+    std::set<BDD_ID> nodes;
+    manager.findNodes(f, nodes);
+    EXPECT_EQ(manager.nodeCount(f), nodes.size());
+}
+
+TEST_F(ManagerTest, Stats_CountIteCallsAndCacheHits) /* NOLINT */
+{
+    BDD_ID a_id = manager.createVar("a");
+    BDD_ID b_id = manager.createVar("b");
+    manager.resetStats();
+
+    manager.and2(a_id, b_id);
+    const ManagerStats &stats = manager.stats();
+    EXPECT_EQ(stats.computedMisses, 1u);
+    EXPECT_EQ(stats.computedHits, 0u);
+    EXPECT_EQ(stats.uniqueLookups, 1u);
+    EXPECT_EQ(stats.uniqueHits, 0u);
+    EXPECT_GT(stats.iteCalls, stats.computedMisses) << "The recursion ends in terminal cases.";
+
+    manager.and2(a_id, b_id);
+    EXPECT_EQ(stats.computedHits, 1u);
+    EXPECT_EQ(stats.computedMisses, 1u);
+
+    manager.resetStats();
+    EXPECT_EQ(manager.stats().iteCalls, 0u);
+}
+
+
+#include "../Trace.h"
+#include <cstdio>
+#include <thread>
+
+TEST_F(ManagerTest, Trace_WritesSpansOfGarbageCollection) /* NOLINT */
+{
+    BDD_ID a_id = manager.createVar("a");
+    BDD_ID b_id = manager.createVar("b");
+    std::vector<BDD_ID> roots = {manager.and2(a_id, b_id)};
+
+    Trace::enable();
+    manager.garbageCollect(roots);
+
+    std::string filepath = "trace_test.json";
+    ASSERT_TRUE(Trace::write(filepath));
+    std::ifstream file(filepath);
+    std::string json((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    EXPECT_EQ(json.rfind("{\"displayTimeUnit\"", 0), 0u);
+    EXPECT_NE(json.find("\"name\": \"garbageCollect\", \"cat\": \"gc\", \"ph\": \"X\""), std::string::npos);
+    file.close();
+
+    // Later tests run untraced, and a new trace starts empty
+    Trace::disable();
+    EXPECT_FALSE(Trace::enabled());
+    ASSERT_TRUE(Trace::write(filepath));
+    file.open(filepath);
+    json.assign((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    EXPECT_EQ(json.find("garbageCollect"), std::string::npos);
+    file.close();
+    std::remove(filepath.c_str());
+}
+
+TEST_F(ManagerTest, Trace_ReusesBuffersOfFinishedThreads) /* NOLINT */
+{
+    Trace::enable();
+    size_t before = Trace::threadBuffers();
+
+    // Like the image workers, every round starts new threads that record a span and end
+    for (int round = 0; round < 100; round++) {
+        std::vector<std::thread> threads;
+        for (int t = 0; t < 4; t++) {
+            threads.emplace_back([round]() { TraceSpan span("worker", "test", round); });
+        }
+        for (auto &thread: threads) {
+            thread.join();
+        }
+    }
+    EXPECT_LE(Trace::threadBuffers(), before + 4) << "Only threads recording at the same time need buffers.";
+    Trace::disable();
+}
+
 // main function for tests (typically handled by main_test.cpp or gtest setup)
 int main(int argc, char **argv) {
     ::testing::InitGoogleTest(&argc, argv);
@@ -0,0 +1,283 @@
+//
+// Loading BDD dumps of the benchmark_tool in text or binary format
+//
+
+#include "BddLoader.h"
+
+#include<algorithm>
+#include<charconv>
+#include<cstring>
+#include<string_view>
+#include<thread>
+#include<unordered_map>
+#include<fcntl.h>
+#include<sys/mman.h>
+#include<sys/stat.h>
+#include<unistd.h>
+
+static const char BINARY_MAGIC[8] = {'V', 'D', 'S', 'B', 'D', 'D', '0', '2'};
+static const size_t BINARY_VERSION = 7; // position of the version digit in BINARY_MAGIC
+
+/* Read-only mapping of a whole file, unmapped when it goes out of scope */
+struct mappedFile {
+	const char *data = nullptr;
+	size_t size = 0;
+	bool valid = false;
+
+	explicit mappedFile(const std::string &file)
+	{
+		int fd = open(file.c_str(), O_RDONLY);
+		if(fd < 0)
+			return;
+		struct stat info{};
+		if(fstat(fd, &info) == 0)
+		{
+			size = static_cast<size_t>(info.st_size);
+			if(size == 0)
+				valid = true;
+			else
+			{
+				void *mapping = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+				if(mapping != MAP_FAILED)
+				{
+					data = static_cast<const char *>(mapping);
+					valid = true;
+					madvise(mapping, size, MADV_SEQUENTIAL);
+				}
+			}
+		}
+		close(fd);
+	}
+
+	~mappedFile()
+	{
+		if(data != nullptr)
+			munmap(const_cast<char *>(data), size);
+	}
+
+	mappedFile(const mappedFile &) = delete;
+	mappedFile &operator=(const mappedFile &) = delete;
+};
+
+/* Cursor over one line of a text dump */
+struct lineParser {
+	const char *p;
+	const char *end;
+
+	bool literal(std::string_view text)
+	{
+		if(static_cast<size_t>(end - p) < text.size() || std::memcmp(p, text.data(), text.size()) != 0)
+			return false;
+		p += text.size();
+		return true;
+	}
+
+	bool number(size_t &value)
+	{
+		auto result = std::from_chars(p, end, value);
+		if(result.ec != std::errc())
+			return false;
+		p = result.ptr;
+		return true;
+	}
+
+	bool hash(uint64_t &value)
+	{
+		auto result = std::from_chars(p, end, value, 16);
+		if(result.ec != std::errc())
+			return false;
+		p = result.ptr;
+		return true;
+	}
+
+	std::string_view word()
+	{
+		const char *start = p;
+		while(p < end && *p != ' ')
+			p++;
+		return {start, static_cast<size_t>(p - start)};
+	}
+};
+
+/* Resolves BDD_IDs to positions, the dumps list their nodes sorted by ID */
+struct idIndex {
+	std::vector<std::pair<size_t, size_t>> ids; // BDD_ID and position, ascending by BDD_ID
+
+	explicit idIndex(const std::vector<node> &nodes)
+	{
+		ids.reserve(nodes.size());
+		for(size_t n = 0; n < nodes.size(); n++)
+			ids.emplace_back(nodes[n].id, n);
+		if(std::is_sorted(ids.rbegin(), ids.rend()))
+			std::reverse(ids.begin(), ids.end());
+		else
+			std::sort(ids.begin(), ids.end());
+	}
+
+	size_t position(size_t bdd_id) const
+	{
+		auto found = std::lower_bound(ids.begin(), ids.end(), std::make_pair(bdd_id, size_t(0)));
+		return (found == ids.end() || found->first != bdd_id) ? NO_NODE : found->second;
+	}
+};
+
+static bool loadText(const char *data, size_t size, const std::string &label, bddDump &BDD)
+{
+	std::unordered_map<std::string_view, int> var_ids;
+	std::vector<std::pair<size_t, size_t>> children; // BDD_IDs of low and high, resolved once all nodes are read
+	std::vector<std::pair<std::string, size_t>> root_ids;
+	uint64_t hash = 0;
+
+	const char *end = data + size;
+	for(const char *p = data; p < end;)
+	{
+		const char *eol = static_cast<const char *>(std::memchr(p, '\n', end - p));
+		if(eol == nullptr)
+			eol = end;
+		lineParser line{p, (eol > p && eol[-1] == '\r') ? eol - 1 : eol};
+		p = eol + 1;
+
+		size_t id, top_var, low, high;
+		if(line.literal("Variable Node: "))
+		{
+			std::string_view var_name;
+			if(!line.number(id) || !line.literal(" Top Var Id: ") || !line.number(top_var) ||
+			   !line.literal(" Top Var Name: ") || (var_name = line.word()).empty() ||
+			   !line.literal(" Low: ") || !line.number(low) || !line.literal(" High: ") || !line.number(high))
+				return false;
+			auto var = var_ids.emplace(var_name, static_cast<int>(BDD.var_names.size()));
+			if(var.second)
+				BDD.var_names.emplace_back(var_name);
+			BDD.nodes.push_back({id, var.first->second, NO_NODE, NO_NODE});
+			children.emplace_back(low, high);
+		}
+		else if(line.literal("Terminal Node: "))
+		{
+			if(!line.number(id))
+				return false;
+			BDD.nodes.push_back({id, -1, NO_NODE, NO_NODE});
+			children.emplace_back(NO_NODE, NO_NODE);
+		}
+		else if(line.literal("Root: "))
+		{
+			std::string_view root_label = line.word();
+			if(!line.literal(" Node: ") || !line.number(id))
+				return false;
+			root_ids.emplace_back(root_label, id);
+			uint64_t root_hash = 0;
+			if(line.literal(" Hash: ") && !line.hash(root_hash))
+				return false;
+			BDD.root_hashes.push_back(root_hash);
+		}
+		else if(line.literal("Hash: "))
+		{
+			if(!line.hash(hash))
+				return false;
+		}
+	}
+
+	idIndex index(BDD.nodes);
+	for(size_t n = 0; n < BDD.nodes.size(); n++)
+	{
+		if(BDD.nodes[n].var >= 0)
+		{
+			BDD.nodes[n].low = index.position(children[n].first);
+			BDD.nodes[n].high = index.position(children[n].second);
+		}
+	}
+
+	if(root_ids.empty() && !BDD.nodes.empty())
+	{
+		BDD.roots.emplace_back(label, index.ids.back().second);
+		BDD.root_hashes.push_back(hash);
+	}
+	for(const auto &root : root_ids)
+		BDD.roots.emplace_back(root.first, index.position(root.second));
+	return true;
+}
+
+static bool loadBinary(const char *data, size_t size, bool hashes, bddDump &BDD)
+{
+	const char *p = data + sizeof(BINARY_MAGIC);
+	const char *end = data + size;
+	auto word = [&](uint64_t &value) {
+		if(end - p < 8)
+			return false;
+		value = 0;
+		for(int byte = 7; byte >= 0; byte--)
+			value = (value << 8) | static_cast<unsigned char>(p[byte]);
+		p += 8;
+		return true;
+	};
+	auto name = [&](std::string &value) {
+		uint64_t length;
+		if(!word(length) || static_cast<uint64_t>(end - p) < length)
+			return false;
+		value.assign(p, length);
+		p += length;
+		return true;
+	};
+
+	uint64_t variables, nodes, roots;
+	if(!word(variables) || !word(nodes) || !word(roots) || nodes > size / 32)
+		return false;
+
+	BDD.var_names.resize(variables);
+	for(uint64_t v = 0; v < variables; v++)
+	{
+		uint64_t var_id;
+		if(!word(var_id) || !name(BDD.var_names[v]))
+			return false;
+	}
+
+	BDD.nodes.reserve(nodes);
+	for(uint64_t n = 0; n < nodes; n++)
+	{
+		uint64_t id, var, high, low;
+		if(!word(id) || !word(var) || !word(high) || !word(low))
+			return false;
+		if(var == UINT64_MAX)
+			BDD.nodes.push_back({id, -1, NO_NODE, NO_NODE});
+		else if(var < variables)
+			BDD.nodes.push_back({id, static_cast<int>(var), (low < nodes) ? low : NO_NODE, (high < nodes) ? high : NO_NODE});
+		else
+			return false;
+	}
+
+	for(uint64_t r = 0; r < roots; r++)
+	{
+		uint64_t root, root_hash = 0;
+		std::string root_label;
+		if(!word(root) || !name(root_label) || (hashes && !word(root_hash)))
+			return false;
+		BDD.roots.emplace_back(root_label, (root < nodes) ? root : NO_NODE);
+		BDD.root_hashes.push_back(root_hash);
+	}
+	return true;
+}
+
+bool loadBDD(const std::string &file, const std::string &label, bddDump &BDD)
+{
+	mappedFile mapped(file);
+	if(!mapped.valid)
+		return false;
+
+	if(mapped.size >= sizeof(BINARY_MAGIC) && std::memcmp(mapped.data, BINARY_MAGIC, BINARY_VERSION) == 0)
+	{
+		char version = mapped.data[BINARY_VERSION];
+		if(version != '1' && version != BINARY_MAGIC[BINARY_VERSION])
+			return false;
+		return loadBinary(mapped.data, mapped.size, version != '1', BDD);
+	}
+	return loadText(mapped.data, mapped.size, label, BDD);
+}
+
+bool loadBDDs(const std::string &file1, const std::string &label1, bddDump &BDD1,
+              const std::string &file2, const std::string &label2, bddDump &BDD2)
+{
+	bool loaded2 = false;
+	std::thread second([&]() { loaded2 = loadBDD(file2, label2, BDD2); });
+	bool loaded1 = loadBDD(file1, label1, BDD1);
+	second.join();
+	return loaded1 && loaded2;
+}
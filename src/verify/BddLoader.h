@@ -0,0 +1,41 @@
+//
+// Loading BDD dumps of the benchmark_tool in text or binary format
+//
+
+#ifndef VDSPROJECT_BDDLOADER_H
+#define VDSPROJECT_BDDLOADER_H
+
+#include<string>
+#include<vector>
+#include<cstddef>
+#include<cstdint>
+
+static const size_t NO_NODE = SIZE_MAX;
+
+/* Nodes are stored densely, children are referenced by their position instead of their BDD_ID */
+struct node {
+	size_t id;    // BDD_ID in the dump, the value for terminals
+	int var;      // position of the variable name in bddDump::var_names, -1 for terminals
+	size_t low;   // position of the low successor, NO_NODE if it is missing in the dump
+	size_t high;  // position of the high successor, NO_NODE if it is missing in the dump
+};
+
+struct bddDump {
+	std::vector<node> nodes;
+	std::vector<std::string> var_names;
+	std::vector<std::pair<std::string, size_t>> roots; // label and position of each root
+	std::vector<uint64_t> root_hashes;                 // structural hash of each root, 0 if the dump has none
+};
+
+/* Reads a dump written by the benchmark_tool. The file is mapped into memory and parsed in place.
+ * Binary files are recognized by their magic, see BddWriter, files of the older VDSBDD01 format have
+ * no hashes. Text files written with --combined list their roots in "Root: <label> Node: <id>" lines,
+ * otherwise the node with the highest ID is the only root and gets the given label. Returns false if
+ * the file cannot be read or is malformed */
+bool loadBDD(const std::string &file, const std::string &label, bddDump &BDD);
+
+/* Loads two dumps at the same time, the second one on a thread of its own */
+bool loadBDDs(const std::string &file1, const std::string &label1, bddDump &BDD1,
+              const std::string &file2, const std::string &label2, bddDump &BDD2);
+
+#endif //VDSPROJECT_BDDLOADER_H
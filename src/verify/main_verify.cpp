@@ -3,128 +3,216 @@
 =============================================================================*/
 
 #include<iostream>
-#include<fstream>
 #include<string>
-#include<sstream>
+#include<vector>
 #include<map>
+#include<unordered_map>
+#include<unordered_set>
+#include<filesystem>
+#include<fstream>
+
+#include "BddLoader.h"
+
+/* Structural comparison of two dumps. Every pair of nodes found equivalent is remembered, so shared
+ * subgraphs are compared once and a check is linear in the size of the BDDs */
+struct equivalenceCheck {
+	const bddDump &BDD1;
+	const bddDump &BDD2;
+	std::vector<int> var_map;              // variable of BDD2 to the variable of BDD1 with the same name, -2 if none
+	std::vector<size_t> match;             // node of BDD2 found equivalent to each node of BDD1
+	std::unordered_set<uint64_t> matches;  // further equivalent pairs, only for dumps with duplicate nodes
+
+	equivalenceCheck(const bddDump &BDD1, const bddDump &BDD2) : BDD1(BDD1), BDD2(BDD2), match(BDD1.nodes.size(), NO_NODE)
+	{
+		std::unordered_map<std::string, int> names;
+		for(size_t v = 0; v < BDD1.var_names.size(); v++)
+			names[BDD1.var_names[v]] = static_cast<int>(v);
+		for(const auto &name : BDD2.var_names)
+		{
+			auto found = names.find(name);
+			var_map.push_back((found == names.end()) ? -2 : found->second);
+		}
+	}
 
-struct node {
-	std::string var_name;
-	int low;
-	int high;
+	bool isEquivalent(size_t root1, size_t root2)
+	{
+		if(root1 == NO_NODE || root2 == NO_NODE)
+			return false;
+		if(match[root1] == root2)
+			return true;
+		uint64_t pair = static_cast<uint64_t>(root1) * BDD2.nodes.size() + root2;
+		if(match[root1] != NO_NODE && matches.count(pair) != 0)
+			return true;
+
+		const node &n1 = BDD1.nodes[root1];
+		const node &n2 = BDD2.nodes[root2];
+		if(n1.var < 0 || n2.var < 0)
+			return n1.var < 0 && n2.var < 0 && n1.id == n2.id;
+		if(n1.var != var_map[n2.var])
+			return false;
+		if(!isEquivalent(n1.low, n2.low) || !isEquivalent(n1.high, n2.high))
+			return false;
+
+		if(match[root1] == NO_NODE)
+			match[root1] = root2;
+		else
+			matches.insert(pair);
+		return true;
+	}
 };
 
-typedef std::map<int, node> uniqueTable;
+/* The dumps of a results directory by output label, from its txt or else its bin directory, or from the
+ * directory itself */
+std::map<std::string, std::filesystem::path> dumpFiles(const std::filesystem::path &dir)
+{
+	std::filesystem::path dump_dir = dir;
+	if(std::filesystem::is_directory(dir / "txt"))
+		dump_dir = dir / "txt";
+	else if(std::filesystem::is_directory(dir / "bin"))
+		dump_dir = dir / "bin";
+
+	std::map<std::string, std::filesystem::path> files;
+	for(const auto &entry : std::filesystem::directory_iterator(dump_dir))
+	{
+		if(entry.path().extension() == ".txt" || entry.path().extension() == ".bdd")
+			files.emplace(entry.path().stem().string(), entry.path());
+	}
+	return files;
+}
 
-bool isEquivalent(const uniqueTable &BDD1, const uniqueTable &BDD2, int root1, int root2)
+/* The structural hashes of a results directory by output label, read from its hashes.csv. Returns false
+ * if the directory has none */
+bool readHashes(const std::filesystem::path &dir, std::map<std::string, std::string> &hashes)
 {
-	if(BDD1.find(root1) == BDD1.end() || BDD2.find(root2) == BDD2.end())
-		return false;
-	if(root1 == 1 && root2 == 1)
-		return true;
-	if(root1 == 0 && root2 == 0)
-		return true;
-	if(root1 != root2 && ( (root1 == 0 || root1 == 1) || (root2 == 0 || root2 == 1) ) )
+	std::ifstream hash_file(dir / "hashes.csv");
+	if(!hash_file.is_open())
 		return false;
-	if(BDD1.at(root1).var_name != BDD2.at(root2).var_name)
+
+	std::string line;
+	std::getline(hash_file, line); // header
+	while(std::getline(hash_file, line))
+	{
+		size_t comma = line.rfind(',');
+		if(comma != std::string::npos)
+			hashes[line.substr(0, comma)] = line.substr(comma + 1);
+	}
+	return true;
+}
+
+/* Compares the outputs of two results directories by their structural hashes. The hash of a BDD only
+ * depends on its variable names and structure, so equal hashes of all outputs mean equivalent outputs.
+ * Returns false if any output differs or is missing, the dumps then decide */
+bool compareHashes(const std::map<std::string, std::string> &hashes1, const std::map<std::string, std::string> &hashes2)
+{
+	if(hashes1.size() != hashes2.size())
 		return false;
-    return isEquivalent(BDD1, BDD2, BDD1.at(root1).low, BDD2.at(root2).low) and isEquivalent(BDD1, BDD2, BDD1.at(root1).high, BDD2.at(root2).high);
+	for(const auto &hash : hashes1)
+	{
+		auto hash2 = hashes2.find(hash.first);
+		if(hash2 == hashes2.end() || hash2->second != hash.second)
+			return false;
+	}
+
+	std::cout << "Equivalent! (" << hashes1.size() << " outputs, by hash)" << std::endl;
+	return true;
+}
+
+int compareDirectories(const std::filesystem::path &dir1, const std::filesystem::path &dir2, bool full)
+{
+	std::map<std::string, std::string> hashes1, hashes2;
+	/* Only a match is taken from the hashes, a hashes.csv of an older build may be stale, so every
+	 * difference is confirmed on the dumps */
+	if(!full && readHashes(dir1, hashes1) && readHashes(dir2, hashes2) && compareHashes(hashes1, hashes2))
+		return 0;
+
+	/* A dump only one of the directories has counts as a difference */
+	std::map<std::string, std::filesystem::path> files1 = dumpFiles(dir1);
+	std::map<std::string, std::filesystem::path> files2 = dumpFiles(dir2);
+	std::map<std::string, bool> labels;
+	for(const auto &file : files1)
+		labels[file.first] = files2.count(file.first) != 0;
+	for(const auto &file : files2)
+		labels[file.first] = files1.count(file.first) != 0;
+
+	size_t outputs = 0, different = 0;
+	for(const auto &label : labels)
+	{
+		bddDump BDD1, BDD2;
+		if(!label.second || !loadBDDs(files1[label.first].string(), label.first, BDD1,
+		                              files2[label.first].string(), label.first, BDD2))
+		{
+			std::cout << label.first << ": missing or invalid" << std::endl;
+			outputs++;
+			different++;
+			continue;
+		}
+
+		std::unordered_map<std::string, size_t> roots2(BDD2.roots.begin(), BDD2.roots.end());
+		equivalenceCheck check(BDD1, BDD2);
+		for(const auto &root : BDD1.roots)
+		{
+			outputs++;
+			auto root2 = roots2.find(root.first);
+			if(root2 == roots2.end() || !check.isEquivalent(root.second, root2->second))
+			{
+				std::cout << root.first << ": Not Equivalent!" << std::endl;
+				different++;
+			}
+		}
+	}
+
+	if(different == 0)
+		std::cout << "Equivalent! (" << outputs << " outputs)" << std::endl;
+	else
+		std::cout << "Not Equivalent! (" << different << " of " << outputs << " outputs)" << std::endl;
+	return 0;
 }
 
 int main(int argc, char* argv[])
 {
 
+	/* --full compares results directories structurally even if both have hashes */
+	bool full = argc > 1 && std::string(argv[1]) == "--full";
+	if(full)
+	{
+		argv++;
+		argc--;
+	}
+
 	/* Number of arguments validation */
 	if (3 > argc)
 	{
 		std::cout << "Must specify a filename!" << std::endl;
+		std::cout << "Usage: verify_tool <bdd1.txt|bdd1.bdd> <bdd2.txt|bdd2.bdd>" << std::endl;
+		std::cout << "       verify_tool [--full] <results_dir1> <results_dir2>" << std::endl;
 		return -1;
 	}
-	
-	uniqueTable BDD1, BDD2;
 
 	std::string BDD1_file = argv[1];
 	std::string BDD2_file = argv[2];
 
-	std::ifstream BDD1_if(BDD1_file.c_str());
-	std::ifstream BDD2_if(BDD2_file.c_str());
+	if(std::filesystem::is_directory(BDD1_file) && std::filesystem::is_directory(BDD2_file))
+		return compareDirectories(BDD1_file, BDD2_file, full);
 
-	if(!BDD1_if.is_open() || !BDD2_if.is_open())
+	bddDump BDD1, BDD2;
+	if(!loadBDDs(BDD1_file, "", BDD1, BDD2_file, "", BDD2) || BDD1.roots.empty() || BDD2.roots.empty())
 	{
 		std::cout << "invalid file!" << std::endl;
 		return -1;
 	}
 
-	std::stringstream ss;
-
-	std::string temp;
-	std::string var_name;
-	int id, top_var;
-
-	while(!BDD1_if.eof())
+	/* Different hashes mean different BDDs, equal ones are still checked */
+	uint64_t hash1 = BDD1.root_hashes.front(), hash2 = BDD2.root_hashes.front();
+	if(hash1 != 0 && hash2 != 0 && hash1 != hash2)
 	{
-		node n;			
-		temp.clear();
-		std::getline(BDD1_if, temp,'\n');
-
-		if(temp.find("Terminal Node: 1") != std::string::npos)
-		{
-			n.var_name = "";
-			n.low = 1;
-			n.high = 1;
-			BDD1.insert(std::pair<int,node>(1,n));
-		}
-		else if(temp.find("Terminal Node: 0") != std::string::npos)
-		{
-			n.var_name = "";
-			n.low = 0;
-			n.high = 0;
-			BDD1.insert(std::pair<int,node>(0,n));
-
-		}
-		else if(temp.find("Variable Node:") != std::string::npos)
-		{
-			ss.clear();
-			ss.str(temp);
-			ss>>temp>>temp>>id>>temp>>temp>>temp>>top_var>>temp>>temp>>temp>>n.var_name>>temp>>n.low>>temp>>n.high;
-			BDD1.insert(std::pair<int,node>(id,n));
-		}
-	}
-
-	while(!BDD2_if.eof())
-	{
-		node n;			
-		temp.clear();
-		std::getline(BDD2_if, temp,'\n');
-
-		if(temp.find("Terminal Node: 1") != std::string::npos)
-		{
-			n.var_name = "";
-			n.low = 1;
-			n.high = 1;
-			BDD2.insert(std::pair<int,node>(1,n));
-		}
-		else if(temp.find("Terminal Node: 0") != std::string::npos)
-		{
-			n.var_name = "";
-			n.low = 0;
-			n.high = 0;
-			BDD2.insert(std::pair<int,node>(0,n));
-
-		}
-		else if(temp.find("Variable Node:") != std::string::npos)
-		{
-			ss.clear();
-			ss.str(temp);
-			ss>>temp>>temp>>id>>temp>>temp>>temp>>top_var>>temp>>temp>>temp>>n.var_name>>temp>>n.low>>temp>>n.high;
-			BDD2.insert(std::pair<int,node>(id,n));
-		}
+		std::cout<<"Not Equivalent!"<<std::endl;
+		return 0;
 	}
 
-	if( isEquivalent(BDD1, BDD2, BDD1.rbegin()->first, BDD2.rbegin()->first) )
+	equivalenceCheck check(BDD1, BDD2);
+	if( check.isEquivalent(BDD1.roots.front().second, BDD2.roots.front().second) )
 		std::cout<<"Equivalent!"<<std::endl;
 	else
 		std::cout<<"Not Equivalent!"<<std::endl;
 	return 0;
 }
-